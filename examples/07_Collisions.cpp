@@ -0,0 +1,89 @@
+#include "Rosalila.h"
+
+int countHits(const vector<unsigned int>& hits)
+{
+  int count = 0;
+  for(int i=0;i<(int)hits.size();i++)
+    for(unsigned int word = hits[i]; word; word &= word - 1)
+      count++;
+  return count;
+}
+
+double getMilliseconds(Uint64 start)
+{
+  return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+int main()
+{
+  rosalila()->init("../assets/config.json");
+  int width = rosalila()->graphics->screen_width;
+  int height = rosalila()->graphics->screen_height;
+
+  //10000 bullets against 100 targets, every bullet is tested against every target
+  const int bullet_count = 10000;
+  const int target_count = 100;
+  const int rounds = 10;
+  vector<Hitbox> bullets;
+  vector<Hitbox> targets;
+  HitboxBatch batch;
+  for(int i=0;i<bullet_count;i++)
+  {
+    bullets.push_back(Hitbox(rand() % width, rand() % height, 4 + rand() % 12, 4 + rand() % 12, rand() % 360));
+    batch.add(&bullets.back());
+  }
+  for(int i=0;i<target_count;i++)
+    targets.push_back(Hitbox(rand() % width, rand() % height, 20 + rand() % 80, 20 + rand() % 80, rand() % 360));
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  int hitbox_hits = 0;
+  for(int round=0;round<rounds;round++)
+    for(int i=0;i<target_count;i++)
+      for(int j=0;j<bullet_count;j++)
+        if(targets[i].collides(bullets[j]))
+          hitbox_hits++;
+  double hitbox_time = getMilliseconds(start) / rounds;
+
+  vector<unsigned int> hits;
+  batch.simd = false;
+  start = SDL_GetPerformanceCounter();
+  int scalar_hits = 0;
+  for(int round=0;round<rounds;round++)
+    for(int i=0;i<target_count;i++)
+    {
+      batch.collides(targets[i].getBox(), hits);
+      scalar_hits += countHits(hits);
+    }
+  double scalar_time = getMilliseconds(start) / rounds;
+
+  batch.simd = true;
+  start = SDL_GetPerformanceCounter();
+  int simd_hits = 0;
+  for(int round=0;round<rounds;round++)
+    for(int i=0;i<target_count;i++)
+    {
+      batch.collides(targets[i].getBox(), hits);
+      simd_hits += countHits(hits);
+    }
+  double simd_time = getMilliseconds(start) / rounds;
+
+  string lines[4];
+  lines[0] = rosalila()->utility->toString(bullet_count) + " bullets against " + rosalila()->utility->toString(target_count) + " targets";
+  lines[1] = "Hitbox::collides: " + rosalila()->utility->toString((int)(hitbox_time * 1000)) + " us, " + rosalila()->utility->toString(hitbox_hits / rounds) + " hits";
+  lines[2] = "HitboxBatch without SIMD: " + rosalila()->utility->toString((int)(scalar_time * 1000)) + " us, " + rosalila()->utility->toString(scalar_hits / rounds) + " hits";
+  lines[3] = "HitboxBatch with " + batch.getInstructionSet() + ": " + rosalila()->utility->toString((int)(simd_time * 1000)) + " us, " + rosalila()->utility->toString(simd_hits / rounds) + " hits";
+  for(int i=0;i<4;i++)
+  {
+    cout<<lines[i]<<endl;
+    rosalila()->utility->writeLogLine(lines[i]);
+  }
+
+  while(true)
+  {
+    rosalila()->graphics->drawRectangle(0,0,width,height,0,0,0,0,255);
+    for(int i=0;i<4;i++)
+      rosalila()->graphics->drawText(lines[i], 0, -75 + i * 50, true, true);
+    rosalila()->update();
+  }
+  return 0;
+}
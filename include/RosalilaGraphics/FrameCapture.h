@@ -0,0 +1,138 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+#ifdef WINDOWS
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef OSX
+#include <SDL.h>
+#include <SDL_opengl.h>
+#endif
+
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//Pixel pack buffers used by turns, a read is mapped two frames after it was sent
+const int frame_capture_buffer_count = 3;
+//Frames read back but not on disk yet, past this the game waits for the writer
+const int frame_capture_max_queued_frames = 8;
+
+//A glReadPixels on its way to a pixel pack buffer
+struct FrameCaptureSlot
+{
+    GLuint buffer;
+    int buffer_size;
+#ifndef OSX
+    GLsync fence;
+#endif
+    bool pending;
+    int frame;
+    int width, height;
+    string filename;
+};
+
+//Read back pixels waiting for the writer thread, rows are top to bottom
+struct CapturedFrame
+{
+    vector<unsigned char> pixels;
+    int width, height;
+    string filename;
+};
+
+//Screenshots and continuous recording without stalling the frame. The pixels are read into a
+//ring of pixel pack buffers and copied out a couple of frames later, a thread encodes them.
+//The file format comes from the extension: .png, .raw for the bare RGBA rows, anything else is BMP.
+//Everything but the writer runs with the GL context.
+class ROSALILA_DLL FrameCapture
+{
+public:
+    bool use_fences;
+    FrameCaptureSlot slots[frame_capture_buffer_count];
+    int next_slot;
+    int frame;
+
+    //Continuous recording
+    bool recording;
+    string path;
+    string extension;
+    int x, y, width, height;
+    int recorded_frames;
+
+    //Writer thread
+    SDL_Thread* writer;
+    SDL_mutex* mutex;
+    SDL_cond* condition;
+    bool running;
+    list<CapturedFrame> queued;
+    //Pixel memory given back by the writer so steady recording does not allocate
+    vector<vector<unsigned char> > free_pixels;
+
+    //Counters
+    int frames_written;
+    int failed;
+    //Times a read was still in flight when its buffer was needed again
+    int stalls;
+    //Times the game waited because the writer fell behind
+    int writer_waits;
+
+    FrameCapture();
+    void init(bool use_fences);
+    //Reads the region as it is now, the file is written later
+    void capture(int x, int y, int w, int h, string filename);
+    //Captures every frame to path00000.extension, path00001.extension...
+    void startRecording(int x, int y, int w, int h, string path, string extension);
+    //Sends the frames still in flight to the writer
+    void stopRecording();
+    //Called right before the swap
+    void endFrame();
+    //Waits until everything is on disk
+    void stop();
+    void collect(FrameCaptureSlot& slot);
+    bool isReady(FrameCaptureSlot& slot);
+    static int threadFunction(void* data);
+    void work();
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+
+#ifdef WINDOWS
+#include <SDL2/SDL.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL.h>
+#endif
+
+#ifdef OSX
+#include <SDL.h>
+#endif
+
+using namespace std;
+
+enum VsyncMode
+{
+    VSYNC_OFF = 0,
+    VSYNC_ON = 1,
+    //Waits for the display unless the frame is late, then swaps right away
+    VSYNC_ADAPTIVE = -1
+};
+
+//SDL_Delay measures the estimate is made of, older ones fade out
+const int frame_pacer_max_sleep_samples = 1000;
+
+//Keeps the frames evenly spaced with the performance counter. Most of the wait is slept, the part
+//where SDL_Delay could wake up late is a busy wait. How late it wakes up is measured as it goes.
+//Also runs the game logic on a fixed timestep:
+//
+//    while(rosalila()->graphics->frame_pacer.tick())
+//        logic();
+//
+class ROSALILA_DLL FramePacer
+{
+public:
+    Uint64 frequency;
+    //When the current frame is meant to start, not when wait returned
+    Uint64 next_frame;
+    Uint64 last_frame;
+    VsyncMode vsync;
+
+    //Measured SDL_Delay(1) in seconds, the busy wait covers the mean plus the standard deviation
+    double sleep_mean;
+    double sleep_variance;
+    int sleep_samples;
+
+    //Fixed timestep, in seconds
+    double tick_rate;
+    double tick_time;
+    double accumulator;
+    //Ticks run per frame at most, a long stall drops the time over it
+    int max_ticks_per_frame;
+    int ticks_this_frame;
+
+    //Seconds between the start of the last two frames
+    double frame_time;
+    //Seconds the last wait slept or spun
+    double wait_time;
+    //Frames that started over a frame late, the schedule starts again from them
+    int late_frames;
+
+    FramePacer();
+    void init(double tick_rate);
+    //Needs the GL context current. Adaptive falls back to on if the driver lacks it.
+    void setVsync(VsyncMode vsync);
+    //Called once per frame, returns when the next frame is due. fps 0 does not wait.
+    void wait(int fps);
+    //True while there is a logic tick left to run this frame
+    bool tick();
+    //How far the frame is between the last tick and the next, from 0 to 1. Useful to interpolate draws.
+    double getInterpolation();
+    double getSeconds(Uint64 counter);
+    //Sleeps while it is safe and spins the rest
+    void waitUntil(Uint64 counter);
+};
+
+#endif
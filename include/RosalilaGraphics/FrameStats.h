@@ -0,0 +1,139 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+
+#ifdef WINDOWS
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef OSX
+#include <SDL.h>
+#include <SDL_opengl.h>
+#endif
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+
+enum FrameStat
+{
+    FRAME_STAT_FRAME_TIME,
+    FRAME_STAT_DRAW_CALLS,
+    FRAME_STAT_VERTICES,
+    FRAME_STAT_TEXTURE_BINDS,
+    FRAME_STAT_TEXTURE_UPLOADS,
+    //CPU time of each subsystem on RosalilaContainer::update
+    FRAME_STAT_INPUTS_TIME,
+    FRAME_STAT_GRAPHICS_TIME,
+    FRAME_STAT_API_INTEGRATOR_TIME,
+    FRAME_STAT_SOUND_TIME,
+    FRAME_STAT_GPU_TIME,
+    FRAME_STAT_COUNT
+};
+
+//Frames the min, average and 99th percentile are taken from
+const int frame_stats_window_size = 120;
+//Timer queries in flight, the GPU time read is this many frames old
+const int frame_stats_query_count = 4;
+
+struct FrameStatSummary
+{
+    float last;
+    float min;
+    float average;
+    float p99;
+};
+
+//Measures of every frame kept over a rolling window. Times are in milliseconds.
+//The GL counters are added on the thread that talks to GL and handed over on endGpuFrame,
+//like the state cache counters. The rest is sampled on the main thread on endFrame.
+//With the render thread both run at the same time, so only the atomic fields cross over.
+class ROSALILA_DLL FrameStats
+{
+public:
+    bool overlay;
+    //Counters of the frame being drawn, only touched by the thread that talks to GL
+    int draw_calls;
+    int vertices;
+    int texture_binds;
+    int texture_uploads;
+    //Counters of the last finished frame, read from the main thread
+    std::atomic<int> last_frame_draw_calls;
+    std::atomic<int> last_frame_vertices;
+    std::atomic<int> last_frame_texture_binds;
+    std::atomic<int> last_frame_texture_uploads;
+
+    //GL_TIME_ELAPSED queries, only on the core profile. The time waiting for the draws is counted too
+    //unless they are sent on the render thread.
+    bool use_timer_queries;
+    GLuint queries[frame_stats_query_count];
+    //Ended and waiting for the result
+    bool query_pending[frame_stats_query_count];
+    int current_query;
+    bool query_running;
+    std::atomic<float> last_gpu_time;
+
+    //Times of the frame being run, RosalilaContainer::update adds the subsystems
+    float times[FRAME_STAT_COUNT];
+
+    vector<float> samples[FRAME_STAT_COUNT];
+    int next_sample;
+    int sample_count;
+
+    FrameStats();
+    void init(bool use_timer_queries, bool overlay);
+    //Adds the time since the start counter and returns the current one so the next measure starts there
+    Uint64 addTime(FrameStat stat, Uint64 start);
+    //GL side, called after the swap
+    void endGpuFrame();
+    //Takes the samples of the frame, frame_time in milliseconds
+    void endFrame(float frame_time);
+    FrameStatSummary getSummary(FrameStat stat);
+    string getName(FrameStat stat);
+    //Text lines of the overlay
+    vector<string> getOverlayLines();
+    void stop();
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+#ifdef WINDOWS
+#include <SDL2/SDL_ttf.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL_ttf.h>
+#endif
+
+#ifdef OSX
+#include <SDL_ttf.h>
+#endif
+
+//SDL_ttf added the version check in 2.0.15, the one on windows_dependencies is older
+#ifndef SDL_TTF_VERSION_ATLEAST
+#define SDL_TTF_VERSION_ATLEAST(X, Y, Z) \
+    (SDL_VERSIONNUM(SDL_TTF_MAJOR_VERSION, SDL_TTF_MINOR_VERSION, SDL_TTF_PATCHLEVEL) >= SDL_VERSIONNUM(X, Y, Z))
+#endif
+
+#include <map>
+#include <string>
+
+#include "Image.h"
+
+using namespace std;
+
+struct GlyphKey
+{
+    TTF_Font* font;
+    int size;
+    //Bold, italic and outlined glyphs of the same font are rasterized apart
+    int style;
+    int outline;
+    Uint32 codepoint;
+
+    bool operator<(const GlyphKey& other) const;
+};
+
+struct Glyph
+{
+    //NULL for glyphs with nothing to draw
+    Image* image;
+    //Horizontal position of the image relative to the pen
+    int offset_x;
+    int advance;
+    //FreeType glyph index, SDL_ttf before 2.0.14 only kerns by index
+    int index;
+};
+
+//Every glyph is rasterized once through SDL_ttf and packed on the texture atlas pages,
+//so drawing text only adds quads to the sprite batch
+class ROSALILA_DLL GlyphAtlas
+{
+public:
+    map<GlyphKey, Glyph> glyphs;
+    int glyphs_rasterized;
+
+    GlyphAtlas();
+    ~GlyphAtlas();
+    Glyph* getGlyph(TTF_Font* font, Uint32 codepoint);
+    //Reads the UTF-8 sequence starting at index and moves index to the next one
+    Uint32 nextCodepoint(const string& text, int& index);
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef GRAPHICS_STATE_CACHE_H
+#define GRAPHICS_STATE_CACHE_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+#ifdef WINDOWS
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef OSX
+#include <SDL_opengl.h>
+#endif
+
+#include <atomic>
+#include <map>
+
+using namespace std;
+
+//Shadow copy of the GL state set by the draw calls, only calls GL when something actually changes.
+//Code that touches this state directly must call invalidate() afterwards.
+class ROSALILA_DLL GraphicsStateCache
+{
+public:
+    map<GLenum,bool> capabilities;
+    bool bound_texture_known;
+    GLuint bound_texture;
+    bool blend_function_known;
+    GLenum blend_source;
+    GLenum blend_destination;
+    //Render targets get the alpha blended apart so they can be drawn premultiplied
+    bool blend_separate_alpha;
+    bool color_known;
+    GLubyte color_red, color_green, color_blue, color_alpha;
+    bool projection_known;
+    int projection_width;
+    int projection_height;
+    //Render targets are drawn upside down so their texture reads like any other image
+    bool projection_bottom_up;
+    bool modelview_identity;
+    bool program_known;
+    GLuint program;
+    bool framebuffer_known;
+    GLuint framebuffer;
+    //Location of the projection matrix on the program in use, -1 on the fixed function pipeline
+    GLint projection_uniform;
+
+    //Counters of the frame being drawn, only touched by the thread that talks to GL
+    int changes_issued;
+    int changes_avoided;
+    //Counters of the last finished frame, safe to read while the render thread draws
+    std::atomic<int> last_frame_changes_issued;
+    std::atomic<int> last_frame_changes_avoided;
+
+    void init();
+    void invalidate();
+    void enable(GLenum capability);
+    void disable(GLenum capability);
+    void bindTexture(GLuint texture);
+    void deleteTexture(GLuint texture);
+    void bindFramebuffer(GLuint framebuffer);
+    void deleteFramebuffer(GLuint framebuffer);
+    void blendFunction(GLenum source, GLenum destination);
+    void color(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha);
+    void forgetColor();
+    //The projection is sent again after switching programs
+    void useProgram(GLuint program, GLint projection_uniform);
+    //Leaves the matrix mode on GL_MODELVIEW, on the core profile it sets the projection uniform of the program in use
+    void orthoProjection(int width, int height, bool bottom_up = false);
+    void loadModelviewIdentity();
+    void endFrame();
+};
+
+#endif
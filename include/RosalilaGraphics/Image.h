@@ -56,10 +56,25 @@
 
 #include "Color.h"
 
+class TextureAtlas;
+
 class ROSALILA_DLL Image
 {
 public:
     GLuint texture;
+    //Area of the texture used by this image, smaller than 0..1 when packed on a texture atlas
+    GLfloat uv_x1;
+    GLfloat uv_y1;
+    GLfloat uv_x2;
+    GLfloat uv_y2;
+    //NULL when the image owns its texture
+    TextureAtlas* texture_atlas;
+    //False until getImageAsync finishes loading it
+    bool ready;
+    //Set instead of ready when getImageAsync could not load the file
+    bool failed;
+    //Not 0 on images made with createRenderTarget
+    GLuint framebuffer;
     int original_width;
     int original_height;
 
@@ -0,0 +1,101 @@
+#ifndef IMAGE_LOADER_H
+#define IMAGE_LOADER_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+#ifdef WINDOWS
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#endif
+
+#ifdef OSX
+#include <SDL.h>
+#include <SDL_image.h>
+#endif
+
+#include <functional>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "Image.h"
+
+using namespace std;
+
+struct ImageLoadRequest
+{
+    string filename;
+    bool use_texture_atlas;
+    Image* image;
+    std::function<void(Image*)> callback;
+    //Filled by the worker, NULL if the file could not be read
+    SDL_Surface* surface;
+    string error;
+};
+
+//Decodes images on a pool of worker threads, the textures are created on the main thread
+//a few at a time so the frame rate holds while a stage loads
+class ROSALILA_DLL ImageLoader
+{
+public:
+    int thread_count;
+    //Milliseconds spent creating textures on every updateScreen, at least one image is created per frame
+    int upload_budget;
+    vector<SDL_Thread*> threads;
+    SDL_mutex* mutex;
+    SDL_cond* condition;
+    bool running;
+    list<ImageLoadRequest> requests;
+    list<ImageLoadRequest> decoded;
+    //Images requested that are not ready yet, 0 once a load screen can go on
+    int loading;
+    //Images that could not be loaded, they are counted out of loading too
+    int failed;
+
+    ImageLoader();
+    //thread_count 0 uses a thread per core but one
+    void init(int thread_count, int upload_budget);
+    //Threads start on the first load
+    Image* load(string filename, bool use_texture_atlas, std::function<void(Image*)> callback);
+    void update();
+    void stop();
+    static int threadFunction(void* data);
+    void work();
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef POST_PROCESS_H
+#define POST_PROCESS_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+#ifdef WINDOWS
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef OSX
+#include <SDL_opengl.h>
+#endif
+
+#include <string>
+#include <vector>
+
+#include "Image.h"
+#include "ShaderProgram.h"
+
+using namespace std;
+
+//A fragment shader run over the whole screen
+struct PostProcessPass
+{
+    ShaderProgram* program;
+    bool enabled;
+    GLint resolution_uniform;
+    GLint time_uniform;
+};
+
+//When an effect or a pass is active the frame is drawn on the scene render target and then
+//goes through the effects pass (grayscale, fade and screen shake) and the user passes on its way
+//to the screen. Needs the core profile, the fixed function renderer applies the effects on every draw.
+class ROSALILA_DLL PostProcess
+{
+public:
+    bool supported;
+    //Same size as the screen, the frame is drawn here while scene_active is true
+    Image* scene;
+    bool scene_active;
+    //Passes write to these by turns, the last one writes to the screen
+    Image* targets[2];
+
+    ShaderProgram effects_program;
+    GLint effects_resolution_uniform;
+    GLint saturation_uniform;
+    GLint fade_uniform;
+    GLint offset_uniform;
+    vector<PostProcessPass> passes;
+    GLuint vertex_array;
+    GLuint vertex_buffer;
+
+    PostProcess();
+    bool init(bool core_profile);
+    //The shader gets image, resolution, time and fragment_texture_coordinate, -1 if it does not compile
+    int addPass(string fragment_source);
+    //saturation is the grayscale effect, 1 keeps the colors. fade is the transparency effect.
+    bool hasEffects(double saturation, double fade, int offset_x, int offset_y);
+    bool isNeeded(double saturation, double fade, int offset_x, int offset_y);
+    //GL side, draws the scene on the screen through every pass
+    void render(float saturation, float fade, float offset_x, float offset_y);
+    void drawPass(GLuint texture);
+};
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+#ifdef WINDOWS
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef OSX
+#include <SDL.h>
+#include <SDL_opengl.h>
+#endif
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Color.h"
+#include "SpriteBatch.h"
+
+using namespace std;
+
+enum RenderCommandType
+{
+    RENDER_COMMAND_SPRITES,
+    RENDER_COMMAND_INSTANCES,
+    RENDER_COMMAND_CLEAR,
+    RENDER_COMMAND_SCREENSHOT,
+    RENDER_COMMAND_CAPTURE,
+    RENDER_COMMAND_RENDER_TARGET,
+    RENDER_COMMAND_POST_PROCESS
+};
+
+//One recorded GL call, first and count point into the arrays of its RenderFrame
+struct RenderCommand
+{
+    RenderCommandType type;
+    //The framebuffer on render target commands
+    GLuint texture;
+    GLenum blend_source;
+    GLenum blend_destination;
+    int first;
+    int count;
+    //Instances, the size of the framebuffer on render target commands
+    GLfloat width, height;
+    //Saturation and fade on post process commands
+    GLfloat u1, v1, u2, v2;
+    //Bottom up on render target commands
+    bool flip;
+    //Screen shake on post process commands
+    GLfloat offset_x, offset_y;
+    //Clear
+    Color color;
+};
+
+struct ScreenshotRequest
+{
+    int x, y, w, h;
+    string filename;
+};
+
+//Everything drawn between two updateScreen calls
+struct RenderFrame
+{
+    vector<RenderCommand> commands;
+    vector<SpriteVertex> vertices;
+    vector<SpriteInstance> instances;
+    vector<ScreenshotRequest> screenshots;
+    //Deleted once the frame is on screen, its commands may still use them
+    vector<GLuint> deleted_textures;
+    vector<GLuint> deleted_framebuffers;
+
+    //Keeps the memory so steady frames do not allocate
+    void clear();
+};
+
+//Owns the GL context while running. The draw calls record on one frame while the
+//thread draws the other one, so the logic of a frame overlaps the rendering of the last one.
+class ROSALILA_DLL RenderThread
+{
+public:
+    bool running;
+    SDL_Thread* thread;
+    SDL_mutex* mutex;
+    SDL_cond* condition;
+    RenderFrame frames[2];
+    RenderFrame* recording_frame;
+    //NULL once the render thread has swapped it
+    RenderFrame* submitted_frame;
+    //Work waiting to run with the context, the caller waits until it is NULL again
+    std::function<void()>* pending_task;
+
+    RenderThread();
+    //Called after the context and the sprite batch are ready, takes the context away from the calling thread
+    bool start();
+    //Draws the submitted frame and gives the context back to the calling thread
+    void stop();
+    void recordSprites(GLuint texture, GLenum blend_source, GLenum blend_destination,
+                       const SpriteVertex* vertices, int count);
+    void recordInstances(GLuint texture, GLenum blend_source, float width, float height,
+                         float u1, float v1, float u2, float v2, bool flip,
+                         float offset_x, float offset_y,
+                         const SpriteInstance* instances, int count);
+    void recordClear(Color color);
+    void recordScreenshot(int x, int y, int w, int h, string filename);
+    //Screenshot through the frame capture
+    void recordCapture(int x, int y, int w, int h, string filename);
+    void recordRenderTarget(GLuint framebuffer, int width, int height, bool bottom_up);
+    void recordPostProcess(float saturation, float fade, float offset_x, float offset_y);
+    void recordTextureDelete(GLuint texture);
+    void recordFramebufferDelete(GLuint framebuffer);
+    //Waits only if the last submitted frame is still being drawn
+    void submitFrame();
+    //Runs the task with the context and waits for it, used to create and update textures
+    void runTask(std::function<void()> task);
+    static int threadFunction(void* data);
+    void loop();
+    void render(RenderFrame* frame);
+};
+
+#endif
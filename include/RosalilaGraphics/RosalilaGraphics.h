@@ -32,11 +32,24 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
 
 #include "Color.h"
 #include "FlatShadow.h"
 #include "Image.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
+#include "GraphicsStateCache.h"
+#include "TextureUploader.h"
+#include "FrameCapture.h"
+#include "PostProcess.h"
+#include "GlyphAtlas.h"
+#include "TextCache.h"
+#include "RenderThread.h"
+#include "ImageLoader.h"
 #include "Timer.h"
+#include "FramePacer.h"
+#include "FrameStats.h"
 #include "../RosalilaUtility/RosalilaUtility.h"
 #include "Drawables/DrawableRectangle.h"
 #include "Drawables/DrawableTriangle.h"
@@ -64,16 +77,27 @@ class ROSALILA_DLL RosalilaGraphics
     SDL_Color textColor;
     int screen_width;
     int screen_height;
+    //Window size in pixels, the screen is scaled to it
+    int screen_resized_width;
+    int screen_resized_height;
     bool fullscreen;
+    //No visible window, the frames are drawn offscreen. See the headless config
+    bool headless;
+    //SDL_VIDEODRIVER from before headless mode set it, empty if there was none
+    std::string previous_video_driver;
     int screen_bpp;
     SDL_Joystick *joystick_1;
     SDL_Joystick *joystick_2;
 
-    //Set fps
+    //Set fps, 0 does not cap
     int frames_per_seccond;
     int frame;
     int current_fps;
     int last_tick;
+    //Waits on frameCap and runs the fixed timestep of the game logic
+    FramePacer frame_pacer;
+    //Draw calls, uploads and times of the last frames, see the stats config
+    FrameStats frame_stats;
 
     Image* notification_background;
     int notification_background_x;
@@ -84,6 +108,15 @@ class ROSALILA_DLL RosalilaGraphics
     ScreenShakeEffect screen_shake_effect;
     GrayscaleEffect grayscale_effect;
     PointExplosionEffect* point_explosion_effect;
+    //Grayscale, transparency and screen shake done on the GPU after the frame is drawn
+    PostProcess post_process;
+    //Effects applied on every draw instead, only without post process support
+    double draw_saturation;
+    double draw_fade;
+    int draw_offset_x;
+    int draw_offset_y;
+    //Copy of the instances with the effects applied, kept so steady frames do not allocate
+    vector<SpriteInstance> effect_instances;
 
     //Image font
     int image_font_space = 0;
@@ -91,19 +124,83 @@ class ROSALILA_DLL RosalilaGraphics
     Image* image_font;
     SDL_Rect image_font_character_rectangles[256];
 
+    //Renderer backend, OpenGL 3.3 core profile with shaders or the fixed function pipeline
+    bool core_profile;
+    SDL_GLContext gl_context;
+    //Records the draw calls and sends them to GL on its own thread, off unless the config asks for it
+    RenderThread render_thread;
+
+    SpriteBatch sprite_batch;
+    //Shadow GL state, last_frame_changes_issued and last_frame_changes_avoided tell how much was saved
+    GraphicsStateCache state_cache;
+    //Every texture upload goes through here
+    TextureUploader texture_uploader;
+    //Screenshots and recordings that do not stall the frame
+    FrameCapture frame_capture;
+
+    //TTF glyphs, shares the texture atlas pages
+    GlyphAtlas glyph_atlas;
+    //Rendered long strings, hits and misses tell if max_memory is big enough
+    TextCache text_cache;
+
+    //Decodes getImageAsync files on worker threads
+    ImageLoader image_loader;
+
+    //Image draws go to, NULL for the screen
+    Image* render_target;
+    //Framebuffer bound on the GL side and the size the draws are projected on
+    GLuint target_framebuffer;
+    int target_width;
+    int target_height;
+    bool target_bottom_up;
+
+    //Texture atlas
+    bool texture_atlas_enabled;
+    int texture_atlas_size;
+    int texture_atlas_max_image_size;
+    vector<TextureAtlas*> texture_atlases;
+
     RosalilaGraphics();
     ~RosalilaGraphics();
     void init();
+    bool createContext(bool core_profile);
+    //GL calls outside of the draw calls must go through here, they run right away if there is no render thread
+    void runOnRenderThread(std::function<void()> task);
+    //Waits until the quads already drawn with the texture are on screen
+    void deleteTexture(GLuint texture);
     Image* getImage(std::string filename);
+    Image* getImage(std::string filename, bool use_texture_atlas);
+    //Returns right away, the image is drawn once ready is true. The callback runs on updateScreen
+    //once the image is ready or failed is set. Do not delete the image before that.
+    Image* getImageAsync(std::string filename, std::function<void(Image*)> callback = nullptr);
+    //Creates the texture of the image, on the texture atlas if it fits
+    void uploadImage(Image* image, SDL_Surface* surface, bool use_texture_atlas, std::string filename);
+    Image* addToTextureAtlas(SDL_Surface* surface, GLenum texture_format);
+    bool addToTextureAtlas(SDL_Surface* surface, GLenum texture_format, Image* image);
+    //An image that can be drawn to with setRenderTarget, starts transparent. NULL if framebuffers are not supported
+    Image* createRenderTarget(int width, int height);
+    //Draws go to the target until setRenderTarget(NULL), updateScreen goes back to the screen
+    void setRenderTarget(Image* target);
+    //Same as setRenderTarget but NULL is always the screen, not the post process scene
+    void switchRenderTarget(Image* target);
+    //GL side of setRenderTarget, bottom_up for images that are drawn later
+    void bindRenderTarget(GLuint framebuffer, int width, int height, bool bottom_up);
+    void deleteFramebuffer(Image* target);
+    //Adds a fragment shader run on the whole frame after the others, see PostProcess. -1 if it fails.
+    int addPostProcessPass(std::string fragment_source);
+    //Color filter with the grayscale and transparency of the draws
+    Color applyColorEffects(Color color);
     void drawImage(Image* texture, int x, int y);
     void draw2DImageBatch(
 	             Image* texture,
 				 int size_x,int size_y,
-				 vector<int> position_x,vector<int>position_y,
+				 const vector<int>& position_x,const vector<int>& position_y,
 				 float scale,
-				 vector<float>rotation,
+				 const vector<float>& rotation,
 				 bool flipHorizontally,
 				 Color color_effects);
+    //Draws count copies of the image on a single call, instances is read once and not kept
+    void drawImageInstances(Image* texture, const SpriteInstance* instances, int count);
     void drawText(std::string text, int position_x, int position_y, bool center_x, bool center_y);
     void drawText(TTF_Font* font, std::string text, int position_x, int position_y, bool center_x, bool center_y);
     void drawRectangle(int x,int y,int width,int height,float rotation,int red,int green,int blue,int alpha);
@@ -113,10 +210,25 @@ class ROSALILA_DLL RosalilaGraphics
     void updateScreen();
     void frameCap();
     void clearScreen(Color color);
+    //With a render thread the file is written once the frame is drawn
     void screenshot(int x, int y, int w, int h, string filename);
+    //Same as screenshot but the pixels are read back and written to disk later, .png, .raw or BMP
+    void screenshotAsync(int x, int y, int w, int h, string filename);
+    //Writes every frame to path00000.extension, path00001.extension... until stopCapture
+    void startCapture(string path, string extension);
+    void stopCapture();
+    //GL side of clearScreen and screenshot
+    void clearColorBuffer(Color color);
+    void saveScreenshot(int x, int y, int w, int h, string filename);
     //Image font
     void initImageFont();
+    //Glyph rectangles are stored on a <font png>.metrics file the first time so later starts skip the scan
+    bool loadImageFontMetrics(std::string path);
+    void saveImageFontMetrics(std::string path);
+    bool scanImageFontMetrics(std::string path);
     void drawText(int x, int y, std::string text);
+    //Frame stats on the top left corner, with the TTF font
+    void drawFrameStats();
     void drawCroppedImage (Image* texture, int x, int y, int crop_x, int crop_y, int crop_w, int crop_h);
 };
 #endif
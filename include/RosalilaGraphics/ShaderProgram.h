@@ -0,0 +1,65 @@
+#ifndef SHADER_PROGRAM_H
+#define SHADER_PROGRAM_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+#ifdef WINDOWS
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef OSX
+#include <SDL_opengl.h>
+#endif
+
+#include <string>
+
+using namespace std;
+
+//Vertex and fragment shader linked together, used by the core profile renderer
+class ROSALILA_DLL ShaderProgram
+{
+public:
+    GLuint program;
+
+    ShaderProgram();
+    ~ShaderProgram();
+    //Compiles and links both sources, compile and link errors are written on the log
+    bool init(string vertex_source, string fragment_source);
+    GLint getUniformLocation(string name);
+    GLuint compile(GLenum type, string source);
+};
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+#ifdef WINDOWS
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef OSX
+#include <SDL_opengl.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "Color.h"
+#include "ShaderProgram.h"
+
+using namespace std;
+
+//Max quads sent on a single draw call, 4 vertices each must fit on GLushort indices
+const int sprite_batch_max_quads = 16384;
+
+//On the core profile the corners stay relative to the pivot and the vertex shader
+//flips and rotates them, on the fixed function pipeline they are already final
+struct SpriteVertex
+{
+    GLfloat x, y;
+    GLfloat u, v;
+    GLubyte red, green, blue, alpha;
+    GLfloat pivot_x, pivot_y;
+    GLfloat rotation;
+    //Flipped corners get mirrored around flip_axis, flip is 0 or 1
+    GLfloat flip_axis;
+    GLfloat flip;
+};
+
+//Per instance data of drawImageInstances, x and y are the top left corner like on drawImage
+//and the image rotates around its center
+struct SpriteInstance
+{
+    GLfloat x, y;
+    GLfloat rotation;
+    GLfloat scale;
+    GLubyte red, green, blue, alpha;
+};
+
+//Layer, blend function and texture of a quad packed so sorting the keys sorts the draws
+struct SortedQuad
+{
+    uint64_t key;
+    int quad;
+};
+
+//Collects textured quads on a streaming vertex buffer and draws them on a single
+//call until the texture or the blend function changes
+class ROSALILA_DLL SpriteBatch
+{
+public:
+    vector<SpriteVertex> vertices;
+    GLuint vertex_buffer;
+    GLuint index_buffer;
+    GLuint current_texture;
+    GLenum current_blend_source;
+    GLenum current_blend_destination;
+    //1x1 white texture so untextured shapes share the same pipeline
+    GLuint white_texture;
+
+    //Core profile
+    bool core_profile;
+    GLuint vertex_array;
+    ShaderProgram shader_program;
+    GLint projection_uniform;
+    //Instanced drawing, a unit quad plus one SpriteInstance per copy
+    GLuint instance_vertex_array;
+    GLuint quad_buffer;
+    GLuint instance_buffer;
+    ShaderProgram instance_shader_program;
+    GLint instance_projection_uniform;
+    GLint instance_size_uniform;
+    GLint instance_texture_rectangle_uniform;
+    GLint instance_flip_uniform;
+    GLint instance_offset_uniform;
+
+    //Layered mode, every quad is kept until flush and then drawn sorted by layer, blend function and texture.
+    //Quads on the same layer with the same texture and blend function keep their drawing order.
+    bool sort_draws;
+    //Lower layers are drawn first, from -8388608 to 8388607
+    int layer;
+    vector<SortedQuad> sort_keys;
+    vector<SortedQuad> sort_scratch;
+    vector<SpriteVertex> sorted_vertices;
+    vector< pair<GLenum,GLenum> > sort_blend_functions;
+    //Draw calls saved by sorting on the frame being drawn and on the last finished one
+    int draws_merged;
+    int last_frame_draws_merged;
+
+    //Returns false if the core profile shaders could not be built
+    bool init(bool core_profile);
+    //Flushes first so the quads already drawn keep the mode they were drawn with
+    void setSortDraws(bool sort_draws);
+    //Corners are relative to the pivot and get rotated around it, same as glTranslatef + glRotatef(-rotation) did.
+    //Flipping swaps x1 and x2 before rotating.
+    void draw(GLuint texture, GLenum blend_source, GLenum blend_destination,
+              float pivot_x, float pivot_y, float rotation, bool flip,
+              float x1, float y1, float x2, float y2,
+              float u1, float v1, float u2, float v2,
+              Color color);
+    //Untextured triangle or quad, points are in screen coordinates
+    void drawShape(float* points_x, float* points_y, int points_count, Color color);
+    //One instanced draw call on the core profile, regular quads on the fixed function pipeline
+    void drawInstances(GLuint texture, GLenum blend_source, float width, float height,
+                       float u1, float v1, float u2, float v2, bool flip,
+                       float offset_x, float offset_y,
+                       const SpriteInstance* instances, int count);
+    //Flushes if the quads drawn so far use another texture or blend function, or if the batch is full
+    void setState(GLuint texture, GLenum blend_source, GLenum blend_destination);
+    //Draws the quads collected so far, or records them when there is a render thread
+    void flush();
+    //Stable LSD radix sort of sort_keys, then draws every run of equal state on a single call
+    void flushSorted();
+    void submit(GLuint texture, GLenum blend_source, GLenum blend_destination,
+                const SpriteVertex* vertices, int count);
+    //The GL calls, only from the thread that owns the context
+    void renderVertices(GLuint texture, GLenum blend_source, GLenum blend_destination,
+                        const SpriteVertex* vertices, int count);
+    void renderInstances(GLuint texture, GLenum blend_source, float width, float height,
+                         float u1, float v1, float u2, float v2, bool flip,
+                         float offset_x, float offset_y,
+                         const SpriteInstance* instances, int count);
+};
+
+#endif
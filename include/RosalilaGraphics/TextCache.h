@@ -0,0 +1,104 @@
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+#ifdef WINDOWS
+#include <SDL2/SDL_opengl.h>
+#include <SDL2/SDL_ttf.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL_opengl.h>
+#include <SDL2/SDL_ttf.h>
+#endif
+
+#ifdef OSX
+#include <SDL_opengl.h>
+#include <SDL_ttf.h>
+#endif
+
+#include <list>
+#include <map>
+#include <string>
+
+using namespace std;
+
+struct TextCacheKey
+{
+    TTF_Font* font;
+    //The same font with another size, style or outline renders other pixels
+    int size;
+    int style;
+    int outline;
+    string text;
+    Uint8 red, green, blue;
+
+    bool operator<(const TextCacheKey& other) const;
+};
+
+struct TextCacheEntry
+{
+    TextCacheKey key;
+    GLuint texture;
+    int width;
+    int height;
+    //Texture memory in bytes
+    int memory;
+};
+
+//Keeps the rendered texture of long strings alive across frames, the least recently
+//drawn ones are deleted when the textures go over max_memory
+class ROSALILA_DLL TextCache
+{
+public:
+    bool enabled;
+    int max_memory;
+    //Shorter strings are drawn glyph by glyph
+    int min_length;
+    int memory_used;
+    int hits;
+    int misses;
+    int evictions;
+    //Most recently used first
+    list<TextCacheEntry> entries;
+    map<TextCacheKey, list<TextCacheEntry>::iterator> index;
+
+    TextCache();
+    void init(bool enabled, int max_memory, int min_length);
+    //Returns NULL if the text could not be rendered
+    TextCacheEntry* get(TTF_Font* font, const string& text, SDL_Color color);
+    void evict();
+    void clear();
+};
+
+#endif
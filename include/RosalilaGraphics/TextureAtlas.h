@@ -0,0 +1,75 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+#ifdef WINDOWS
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef OSX
+#include <SDL_opengl.h>
+#endif
+
+#include <vector>
+
+using namespace std;
+
+struct SkylineNode
+{
+    int x;
+    int y;
+    int width;
+};
+
+//Big texture where small images get packed using the skyline bottom-left heuristic
+class ROSALILA_DLL TextureAtlas
+{
+public:
+    GLuint texture;
+    int width;
+    int height;
+    vector<SkylineNode> skyline;
+
+    TextureAtlas(int width, int height);
+    ~TextureAtlas();
+    //Reserves a width x height area, returns false if it does not fit
+    bool insert(int width, int height, int &x, int &y);
+    //Returns the resulting y or -1 if the rectangle does not fit at that skyline node
+    int fit(int node_index, int width, int height);
+};
+
+#endif
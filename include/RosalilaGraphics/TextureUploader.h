@@ -0,0 +1,90 @@
+#ifndef TEXTURE_UPLOADER_H
+#define TEXTURE_UPLOADER_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+#ifdef WINDOWS
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL_opengl.h>
+#endif
+
+#ifdef OSX
+#include <SDL_opengl.h>
+#endif
+
+#include <vector>
+
+using namespace std;
+
+//Pixel unpack buffers used by turns
+const int texture_uploader_buffer_count = 4;
+//Bigger uploads skip the buffers so they do not grow without limit
+const int texture_uploader_max_buffer_size = 8*1024*1024;
+
+//Every texture is created and updated through here. The pixels are copied to a pixel unpack buffer
+//and GL reads them from it later, so the upload does not stall waiting on the draws already sent.
+//On the core profile a fence tells when a buffer can be written again, otherwise it is orphaned.
+class ROSALILA_DLL TextureUploader
+{
+public:
+    bool use_fences;
+    GLuint buffers[texture_uploader_buffer_count];
+    int buffer_sizes[texture_uploader_buffer_count];
+#ifndef OSX
+    GLsync fences[texture_uploader_buffer_count];
+#endif
+    int next_buffer;
+
+    //Counters
+    int buffered_uploads;
+    int direct_uploads;
+    //Times a fence showed the next buffer was still in use and it got new storage instead of waiting
+    int orphaned_buffers;
+
+    TextureUploader();
+    void init(bool use_fences);
+    //pitch is the size in bytes of a row of pixels, pixels may be NULL
+    GLuint createTexture(int width, int height, GLint internal_format, GLenum format,
+                         const void* pixels, int pitch, GLint filter);
+    void updateTexture(GLuint texture, int x, int y, int width, int height, GLenum format,
+                       const void* pixels, int pitch);
+    //Leaves the pixels tightly packed on the bound unpack buffer, returns false if they did not fit
+    bool fillBuffer(int width, int height, int bytes_per_pixel, const void* pixels, int pitch);
+    //Called after the GL call that reads the buffer filled last
+    void releaseBuffer();
+};
+
+#endif
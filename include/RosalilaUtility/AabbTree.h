@@ -0,0 +1,109 @@
+#ifndef AABB_TREE_H
+#define AABB_TREE_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+#include <vector>
+
+#include "OrientedBox.h"
+
+using namespace std;
+
+class Hitbox;
+
+const int aabb_tree_null_node = -1;
+//Pixels the bounds of a leaf are grown by, it is only moved in the tree once it leaves them
+const float aabb_tree_default_margin = 8;
+
+class ROSALILA_DLL AabbTreeNode
+{
+public:
+    //Grown by the margin on leaves, around both children on the others
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+    //Next free node while the node is not used
+    int parent;
+    //aabb_tree_null_node on leaves
+    int child1;
+    int child2;
+    //0 on leaves, -1 on free nodes
+    int height;
+    Hitbox* hitbox;
+    void* data;
+};
+
+//Bounding box tree for hitboxes that move rarely, stage geometry, big bosses etc.
+//Unlike CollisionWorld nothing is rebuilt, update only does work on a leaf that left its grown bounds.
+//The handles are the leaf node indexes and stay the same until remove.
+class ROSALILA_DLL AabbTree
+{
+public:
+    vector<AabbTreeNode> nodes;
+    int root;
+    int free_list;
+    float margin;
+    int leaf_count;
+    //Times update had to move a leaf in the tree
+    int moved_leaves;
+    //Nodes still to be visited on queries, kept to avoid allocating
+    vector<int> stack;
+
+    AabbTree();
+    AabbTree(float margin);
+    //The hitbox must live until it is removed. Returns its handle
+    int insert(Hitbox* hitbox, void* data = NULL);
+    //Call after the hitbox moved or changed size, true if the tree changed
+    bool update(int handle);
+    void remove(int handle);
+    void clear();
+    Hitbox* getHitbox(int handle);
+    void* getData(int handle);
+    int getHeight();
+    //Handles of the hitboxes that collide with the box, handles is cleared first
+    void query(const OrientedBox& box, vector<int>& handles);
+    //Closest hitbox crossed by the segment or aabb_tree_null_node, fraction goes from 0 on from to 1 on to
+    int raycast(float from_x, float from_y, float to_x, float to_y, float* fraction = NULL);
+
+    int allocateNode();
+    void freeNode(int index);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    //Rotates the node if one child is deeper than the other by more than one, returns the node now on its place
+    int balance(int index);
+    //Bounds and height from the children
+    void refit(int index);
+};
+
+#endif
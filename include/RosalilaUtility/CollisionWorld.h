@@ -0,0 +1,113 @@
+#ifndef COLLISION_WORLD_H
+#define COLLISION_WORLD_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+#include <vector>
+
+#include "OrientedBox.h"
+
+using namespace std;
+
+class Hitbox;
+
+const float collision_world_default_cell_size = 64;
+//Boxes over more cells than this are tested against every other one instead
+const int collision_world_max_cells_per_box = 64;
+
+//a hits b, a's mask matched b's layer. Both are ids given by add
+class ROSALILA_DLL CollisionPair
+{
+public:
+    int a;
+    int b;
+};
+
+class ROSALILA_DLL CollisionWorldEntry
+{
+public:
+    Hitbox* hitbox;
+    unsigned int layer;
+    unsigned int mask;
+    void* data;
+    bool active;
+    //Too big for the cells on the last queryPairs
+    bool oversized;
+};
+
+//Hitbox of an entry placed on a cell of the spatial hash
+class ROSALILA_DLL CollisionWorldCell
+{
+public:
+    int x;
+    int y;
+    int id;
+    int bucket;
+};
+
+//Spatial hash rebuilt on every queryPairs, linear on the number of hitboxes.
+//Two hitboxes are tested when the mask of one of them has a bit of the layer of the other.
+class ROSALILA_DLL CollisionWorld
+{
+public:
+    float cell_size;
+    vector<CollisionWorldEntry> entries;
+    vector<int> free_ids;
+
+    //Rebuilt by queryPairs, kept to avoid allocating every frame
+    vector<OrientedBox> boxes;
+    vector<CollisionWorldCell> cells;
+    vector<CollisionWorldCell> sorted_cells;
+    vector<int> bucket_starts;
+    vector<int> oversized;
+    vector<CollisionPair> pairs;
+
+    //Pairs that shared a cell and had a matching layer on the last queryPairs
+    int candidate_pairs;
+
+    CollisionWorld();
+    CollisionWorld(float cell_size);
+    //The hitbox is read on every queryPairs, it must live until it is removed. Returns its id
+    int add(Hitbox* hitbox, unsigned int layer, unsigned int mask, void* data = NULL);
+    void remove(int id);
+    void clear();
+    void setLayer(int id, unsigned int layer, unsigned int mask);
+    Hitbox* getHitbox(int id);
+    void* getData(int id);
+    //Every pair that collides right now, valid until the next call
+    const vector<CollisionPair>& queryPairs();
+    //Narrowphase, adds the pair if the hitboxes collide
+    void testPair(int id1, int id2);
+};
+
+#endif
@@ -34,6 +34,7 @@
 
 
 #include "Line.h"
+#include "OrientedBox.h"
 #include "../RosalilaGraphics/RosalilaGraphics.h"
 #include "../RosalilaSound/RosalilaSound.h"
 #include "../RosalilaInputs/RosalilaInputs.h"
@@ -45,10 +46,18 @@ public:
     int x,y;
     int width,height;
     float angle;
+    //Kept up to date by the setters
     Line line1;
     Line line2;
     Line line3;
     Line line4;
+    //Float corners and axes the collision test uses, worked out on getBox after the hitbox changes
+    mutable OrientedBox box;
+    mutable bool box_outdated;
+    //Sine and cosine are only worked out again when the angle changes
+    float cached_angle;
+    double sine;
+    double cosine;
 public:
     Hitbox();
     Hitbox(int x,int y,int width,int height,float angle);
@@ -65,9 +74,11 @@ public:
     void setHeight(int height);
     void setAngle(float angle);
     void setValues(int x,int y, int width, int height,float angle);
-    bool collides(Hitbox hitbox_param);
-    bool collides(Hitbox hitbox_param,int hitbox_x,int hitbox_y,int hitbox_angle);
+    bool collides(const Hitbox& hitbox_param);
+    bool collides(const Hitbox& hitbox_param,int hitbox_x,int hitbox_y,int hitbox_angle);
+    //Call after changing x, y etc. directly instead of with the setters
     void setLines();
+    const OrientedBox& getBox() const;
     Hitbox getFlippedHitbox();
 };
 
@@ -0,0 +1,84 @@
+#ifndef HITBOX_BATCH_H
+#define HITBOX_BATCH_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+#include <string>
+#include <vector>
+
+#include "OrientedBox.h"
+
+using namespace std;
+
+class Hitbox;
+
+//OrientedBox members split on one array each so several boxes are tested on a single instruction.
+//The test is the same as OrientedBox::overlaps and gives the same results as Hitbox::collides.
+//SSE is used on x86 builds, AVX with the ROSALILA_AVX2 CMake option, plain C++ on the others.
+class ROSALILA_DLL HitboxBatch
+{
+public:
+    vector<float> center_x;
+    vector<float> center_y;
+    vector<float> axis0_x;
+    vector<float> axis0_y;
+    vector<float> axis1_x;
+    vector<float> axis1_y;
+    vector<float> half_width;
+    vector<float> half_height;
+    vector<float> min_x;
+    vector<float> min_y;
+    vector<float> max_x;
+    vector<float> max_y;
+    //Off to test with plain C++ only
+    bool simd;
+
+    HitboxBatch();
+    void clear();
+    void reserve(int size);
+    int size();
+    //Returns the index of the box on the batch
+    int add(const OrientedBox& box);
+    int add(Hitbox* hitbox);
+    void set(int index, const OrientedBox& box);
+    //Bit i%32 of hits[i/32] is set when the box collides with box first+i, hits needs (count+31)/32 words
+    void collides(const OrientedBox& box, int first, int count, unsigned int* hits);
+    //Same for the whole batch, hits is resized
+    void collides(const OrientedBox& box, vector<unsigned int>& hits);
+    //One row of (others.size()+31)/32 words for each box of this batch against every box of others
+    void collides(HitboxBatch& others, vector<unsigned int>& hits);
+    //"AVX", "SSE" or "None"
+    string getInstructionSet();
+};
+
+#endif
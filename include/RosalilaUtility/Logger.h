@@ -0,0 +1,131 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+
+#ifdef WINDOWS
+#include <SDL2/SDL.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL.h>
+#endif
+
+#ifdef OSX
+#include <SDL.h>
+#endif
+
+#include <atomic>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+enum LogLevel
+{
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_WARNING,
+    LOG_ERROR
+};
+
+//Lines waiting to be written, a power of two. Lines over it are dropped instead of waiting.
+const int logger_queue_size = 1024;
+//Longer lines are cut
+const int logger_max_line_length = 512;
+//The same line is written this many times a second at most, the rest are counted
+const int logger_max_repeats_per_second = 5;
+const int logger_rate_slots = 64;
+
+struct LogMessage
+{
+    //Tells the slot is free to write or ready to read, see Logger::write
+    std::atomic<Uint32> sequence;
+    LogLevel level;
+    Uint64 time;
+    int skipped;
+    int length;
+    char text[logger_max_line_length];
+};
+
+struct LogRateSlot
+{
+    std::atomic<Uint32> hash;
+    std::atomic<Uint32> second;
+    std::atomic<int> count;
+    std::atomic<int> skipped;
+};
+
+//Lines are copied to a bounded queue any thread can write to without locks and a thread writes them to the file.
+//Writing never waits, if the queue is full the line is dropped and counted.
+class ROSALILA_DLL Logger
+{
+public:
+    string filename;
+    //Lines below are ignored
+    LogLevel min_level;
+    LogMessage* queue;
+    std::atomic<Uint32> write_position;
+    //Only the writer thread moves it
+    Uint32 read_position;
+    LogRateSlot rate_slots[logger_rate_slots];
+    std::atomic<int> dropped;
+    std::atomic<bool> clear_requested;
+    Uint64 start_counter;
+    Uint64 frequency;
+
+    ofstream file;
+    SDL_Thread* thread;
+    SDL_sem* semaphore;
+    //Writes right away when the thread could not be started
+    SDL_mutex* mutex;
+    std::atomic<bool> running;
+    bool started;
+
+    Logger();
+    //Truncates the file, lines written before are kept
+    void start(string filename);
+    //Writes what is left
+    void stop();
+    //Truncates the file
+    void clear();
+    //False if the line was dropped
+    bool write(LogLevel level, string text);
+    //Writes the queued lines, only from one thread at a time
+    void flush();
+    static int threadFunction(void* data);
+    void work();
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef ORIENTED_BOX_H
+#define ORIENTED_BOX_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+#include <cmath>
+
+//Rectangle turned around its first corner, same placement as the Hitbox lines.
+//The angle is in degrees and y goes down the screen.
+class ROSALILA_DLL OrientedBox
+{
+public:
+    //Same order as the Hitbox lines, the first one is x,y
+    float corner_x[4];
+    float corner_y[4];
+    //Unit directions of the width and the height edges, also the separating axes
+    float axis_x[2];
+    float axis_y[2];
+    //Half of the width and the height, always positive
+    float half_extent[2];
+    float center_x;
+    float center_y;
+    //Bounds around the corners for the early reject
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+
+    OrientedBox();
+    OrientedBox(float x,float y,float width,float height,float angle);
+    void set(float x,float y,float width,float height,float angle);
+    //Same as set with the sine and cosine of the angle already known
+    void set(float x,float y,float width,float height,float sine,float cosine);
+    //Separating axis test, touching edges and boxes inside the other count as a hit
+    bool overlaps(const OrientedBox& box) const;
+    //Sine and cosine of an angle in degrees, whole degrees come from a table
+    static void getSineCosine(float angle, double* sine, double* cosine);
+};
+
+#endif
@@ -17,7 +17,12 @@
 using namespace std;
 #define PI 3.14159265
 
+#include "Tracer.h"
+#include "Logger.h"
 #include "Hitbox.h"
+#include "CollisionWorld.h"
+#include "AabbTree.h"
+#include "HitboxBatch.h"
 
 class Hitbox;
 
@@ -29,9 +34,15 @@ public:
     int current_non_seeded_random_number_index;
     map< string,vector<int>* > checksums;
     string absolute_path;
+    //Off unless the trace config or start() turns it on
+    Tracer tracer;
+    //Writes the log file on its own thread
+    Logger logger;
 
     void init();
+    //Lines starting with "Warning: " or "Error: " get that level
     bool writeLogLine(std::string text);
+    bool writeLogLine(LogLevel level, std::string text);
     bool clearLog();
     std::string toString(int number);
     bool pointIsInRect(int point_x,int point_y,
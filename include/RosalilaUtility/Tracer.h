@@ -0,0 +1,126 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+//Choose your build platform by defining it:
+#ifdef __linux__
+#define LINUX
+#endif
+
+#ifdef __APPLE__
+#define OSX
+#endif
+#ifdef __MACH__
+#define OSX
+#endif
+
+#ifdef _WIN32
+#define WINDOWS
+#endif
+#ifdef _WIN64
+#define WINDOWS
+#endif
+
+#ifdef ROSALILA_STATICLIB
+#  define ROSALILA_DLL
+#elif defined(WINDOWS)
+#  ifdef ROSALILA_DYNAMICLIB
+#    define ROSALILA_DLL  __declspec(dllexport)
+#  else
+#    define ROSALILA_DLL  __declspec(dllimport)
+#  endif
+#else
+#  define ROSALILA_DLL
+#endif
+
+
+
+#ifdef WINDOWS
+#include <SDL2/SDL.h>
+#endif
+
+#ifdef LINUX
+#include <SDL2/SDL.h>
+#endif
+
+#ifdef OSX
+#include <SDL.h>
+#endif
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//Events kept per thread, older ones are written over
+const int trace_buffer_size = 65536;
+
+struct TraceEvent
+{
+    //Must outlive the trace, a string literal
+    const char* name;
+    Uint64 start;
+    Uint64 end;
+};
+
+//Written only by its thread, count is published after the event so the export can read along
+struct TraceBuffer
+{
+    SDL_threadID thread;
+    string thread_name;
+    vector<TraceEvent> events;
+    std::atomic<Uint64> count;
+};
+
+//Scoped markers of where the frame time goes, exported as Chrome trace JSON.
+//Open the file on chrome://tracing or ui.perfetto.dev. Stopped, a marker costs a branch.
+//Define ROSALILA_NO_TRACE to build the markers out.
+class ROSALILA_DLL Tracer
+{
+public:
+    static bool enabled;
+    Uint64 start_counter;
+    SDL_mutex* mutex;
+    vector<TraceBuffer*> buffers;
+
+    Tracer();
+    ~Tracer();
+    void start();
+    void stop();
+    //Shows on the trace instead of the thread id
+    void setThreadName(string name);
+    void record(const char* name, Uint64 start, Uint64 end);
+    //Writes the events still on the buffers, false if the file can not be written
+    bool exportChromeTrace(string filename);
+    TraceBuffer* getThreadBuffer();
+};
+
+class ROSALILA_DLL TraceScope
+{
+public:
+    const char* name;
+    Uint64 start;
+
+    TraceScope(const char* name)
+    {
+        this->name = name;
+        start = Tracer::enabled ? SDL_GetPerformanceCounter() : 0;
+    }
+    ~TraceScope()
+    {
+        if(start)
+            end();
+    }
+    void end();
+};
+
+#define ROSALILA_TRACE_CONCAT_INNER(a, b) a##b
+#define ROSALILA_TRACE_CONCAT(a, b) ROSALILA_TRACE_CONCAT_INNER(a, b)
+#ifdef ROSALILA_NO_TRACE
+#define ROSALILA_TRACE(name)
+#else
+//Measures until the end of the scope
+#define ROSALILA_TRACE(name) TraceScope ROSALILA_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#endif
+
+#endif
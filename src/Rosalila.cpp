@@ -16,15 +16,29 @@ RosalilaContainer::RosalilaContainer()
 
 void RosalilaContainer::update()
 {
+  ROSALILA_TRACE("RosalilaContainer::update");
+  FrameStats* frame_stats = &graphics->frame_stats;
+  Uint64 time = SDL_GetPerformanceCounter();
   receiver->updateInputs();
+  time = frame_stats->addTime(FRAME_STAT_INPUTS_TIME, time);
   graphics->updateScreen();
+  time = frame_stats->addTime(FRAME_STAT_GRAPHICS_TIME, time);
+  //Waiting for the next frame is not graphics work
+  frame_stats->times[FRAME_STAT_GRAPHICS_TIME] -= (float)(graphics->frame_pacer.wait_time * 1000);
   api_integrator->updateCallbacks();
+  time = frame_stats->addTime(FRAME_STAT_API_INTEGRATOR_TIME, time);
   sound->update();
+  frame_stats->addTime(FRAME_STAT_SOUND_TIME, time);
   //net->update();
+  frame_stats->endFrame((float)(graphics->frame_pacer.frame_time * 1000));
 
   std::string error = SDL_GetError();
   if (error != "")
+  {
     rosalila()->utility->writeLogLine("Error: " + error);
+    //Reported once, not on every frame after
+    SDL_ClearError();
+  }
 }
 
 void RosalilaContainer::init(std::string config_file_path)
@@ -38,6 +52,39 @@ void RosalilaContainer::init(std::string config_file_path)
   this->utility->writeLogLine("Initializing utility.");
   utility->init();
   this->utility->writeLogLine("Utility initialized.");
+  Node* root_node = parser->getNodes(config_file_path);
+  Node* log_node = root_node->getNodeByName("log");
+  if(log_node && log_node->hasAttribute("level"))
+  {
+    std::string level = log_node->attributes["level"];
+    if(level == "debug")
+      utility->logger.min_level = LOG_DEBUG;
+    else if(level == "warning")
+      utility->logger.min_level = LOG_WARNING;
+    else if(level == "error")
+      utility->logger.min_level = LOG_ERROR;
+    else
+      utility->logger.min_level = LOG_INFO;
+  }
+  Node* trace_node = root_node->getNodeByName("trace");
+  if(trace_node && trace_node->attributes["enabled"]=="yes")
+  {
+    utility->tracer.start();
+    utility->tracer.setThreadName("Main");
+  }
+  //The drivers are picked when the SDL subsystems start, the environment wins over the config
+  Node* renderer_node = root_node->getNodeByName("renderer");
+  if(renderer_node && renderer_node->attributes["headless"]=="yes")
+  {
+    this->utility->writeLogLine("Headless mode, using the offscreen video driver and the dummy audio driver.");
+    //Restored if the offscreen window can not be made
+    const char* video_driver = SDL_getenv("SDL_VIDEODRIVER");
+    graphics->previous_video_driver = video_driver ? video_driver : "";
+    SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    //Mesa llvmpipe, no GPU needed
+    SDL_setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+  }
   this->utility->writeLogLine("Initializing sound.");
   sound->init();
   this->utility->writeLogLine("Sound initialized.");
@@ -90,6 +90,7 @@ string RosalilaApiIntegrator::getData(string key)
 
 void RosalilaApiIntegrator::updateCallbacks()
 {
+    ROSALILA_TRACE("RosalilaApiIntegrator::updateCallbacks");
 	#ifdef STEAM
     steamUpdateCallbacks();
 	#endif
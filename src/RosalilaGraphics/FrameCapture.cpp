@@ -0,0 +1,328 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+//Runs on the writer thread, no log lines from here
+static bool writeFrame(CapturedFrame& captured)
+{
+    ROSALILA_TRACE("FrameCapture writeFrame");
+    string filename = captured.filename;
+    string extension = filename.size() > 4 ? filename.substr(filename.size() - 4) : "";
+
+    if(extension == ".raw")
+    {
+        ofstream file(filename.c_str(), ios::out | ios::binary);
+        if(!file.is_open())
+            return false;
+        file.write((char*)&captured.pixels[0], captured.pixels.size());
+        return file.good();
+    }
+
+    //The alpha of the back buffer is not what is on screen, leave it out
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    Uint32 red_mask = 0xff000000, green_mask = 0x00ff0000, blue_mask = 0x0000ff00;
+#else
+    Uint32 red_mask = 0x000000ff, green_mask = 0x0000ff00, blue_mask = 0x00ff0000;
+#endif
+    SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(&captured.pixels[0], captured.width, captured.height, 32,
+                                                    captured.width * 4, red_mask, green_mask, blue_mask, 0);
+    if(!surface)
+        return false;
+    int result;
+    if(extension == ".png")
+        result = IMG_SavePNG(surface, filename.c_str());
+    else
+        result = SDL_SaveBMP(surface, filename.c_str());
+    SDL_FreeSurface(surface);
+    return result == 0;
+}
+
+FrameCapture::FrameCapture()
+{
+    use_fences = false;
+    next_slot = 0;
+    frame = 0;
+    recording = false;
+    x = y = width = height = 0;
+    recorded_frames = 0;
+    writer = NULL;
+    mutex = NULL;
+    condition = NULL;
+    running = false;
+    frames_written = 0;
+    failed = 0;
+    stalls = 0;
+    writer_waits = 0;
+    for(int i=0;i<frame_capture_buffer_count;i++)
+    {
+        slots[i].buffer = 0;
+        slots[i].buffer_size = 0;
+#ifndef OSX
+        slots[i].fence = 0;
+#endif
+        slots[i].pending = false;
+    }
+}
+
+void FrameCapture::init(bool use_fences)
+{
+#ifdef OSX
+    use_fences = false;
+#endif
+    this->use_fences = use_fences;
+    for(int i=0;i<frame_capture_buffer_count;i++)
+    {
+        glGenBuffers(1, &slots[i].buffer);
+        slots[i].buffer_size = 0;
+        slots[i].pending = false;
+    }
+}
+
+void FrameCapture::capture(int x, int y, int w, int h, string filename)
+{
+    if(w <= 0 || h <= 0)
+        return;
+
+    if(!running)
+    {
+        mutex = SDL_CreateMutex();
+        condition = SDL_CreateCond();
+        running = true;
+        writer = SDL_CreateThread(threadFunction, "RosalilaFrameCapture", this);
+        if(!writer)
+            rosalila()->utility->writeLogLine("Warning: Could not start the frame capture thread, captures are written right away.");
+    }
+
+    FrameCaptureSlot& slot = slots[next_slot];
+    if(slot.pending)
+    {
+        stalls++;
+        collect(slot);
+    }
+
+    int size = w * h * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if(size > slot.buffer_size)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        slot.buffer_size = size;
+    }
+    glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)0);
+#ifndef OSX
+    if(use_fences)
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.pending = true;
+    slot.frame = frame;
+    slot.width = w;
+    slot.height = h;
+    slot.filename = filename;
+    next_slot = (next_slot + 1) % frame_capture_buffer_count;
+}
+
+void FrameCapture::startRecording(int x, int y, int w, int h, string path, string extension)
+{
+    this->x = x;
+    this->y = y;
+    this->width = w;
+    this->height = h;
+    this->path = path;
+    this->extension = extension;
+    recorded_frames = 0;
+    recording = true;
+}
+
+void FrameCapture::stopRecording()
+{
+    recording = false;
+    for(int i=0;i<frame_capture_buffer_count;i++)
+    {
+        FrameCaptureSlot& slot = slots[(next_slot + i) % frame_capture_buffer_count];
+        if(slot.pending)
+            collect(slot);
+    }
+}
+
+void FrameCapture::endFrame()
+{
+    if(recording)
+    {
+        char number[16];
+        snprintf(number, sizeof(number), "%05d", recorded_frames);
+        capture(x, y, width, height, path + number + "." + extension);
+        recorded_frames++;
+    }
+    frame++;
+
+    //Oldest first so the files reach the writer in order
+    for(int i=0;i<frame_capture_buffer_count;i++)
+    {
+        FrameCaptureSlot& slot = slots[(next_slot + i) % frame_capture_buffer_count];
+        if(!slot.pending)
+            continue;
+        if(!isReady(slot))
+            break;
+        collect(slot);
+    }
+}
+
+bool FrameCapture::isReady(FrameCaptureSlot& slot)
+{
+#ifndef OSX
+    if(use_fences && slot.fence)
+    {
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+    }
+#endif
+    return frame - slot.frame >= 2;
+}
+
+void FrameCapture::collect(FrameCaptureSlot& slot)
+{
+    int row_size = slot.width * 4;
+    int size = row_size * slot.height;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const unsigned char* mapped;
+#ifndef OSX
+    if(use_fences)
+    {
+        mapped = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+        if(slot.fence)
+            glDeleteSync(slot.fence);
+        slot.fence = 0;
+    }
+    else
+#endif
+    {
+        mapped = (const unsigned char*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    }
+    slot.pending = false;
+
+    if(!mapped)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        SDL_LockMutex(mutex);
+        failed++;
+        SDL_UnlockMutex(mutex);
+        return;
+    }
+
+    CapturedFrame captured;
+    captured.width = slot.width;
+    captured.height = slot.height;
+    captured.filename = slot.filename;
+
+    SDL_LockMutex(mutex);
+    if(writer && (int)queued.size() >= frame_capture_max_queued_frames)
+    {
+        writer_waits++;
+        while((int)queued.size() >= frame_capture_max_queued_frames)
+            SDL_CondWait(condition, mutex);
+    }
+    if(!free_pixels.empty())
+    {
+        captured.pixels.swap(free_pixels.back());
+        free_pixels.pop_back();
+    }
+    SDL_UnlockMutex(mutex);
+
+    //GL rows go bottom to top
+    captured.pixels.resize(size);
+    for(int row=0;row<slot.height;row++)
+        memcpy(&captured.pixels[row * row_size], mapped + (slot.height - 1 - row) * row_size, row_size);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if(!writer)
+    {
+        if(writeFrame(captured))
+            frames_written++;
+        else
+            failed++;
+        return;
+    }
+
+    SDL_LockMutex(mutex);
+    queued.push_back(CapturedFrame());
+    queued.back().pixels.swap(captured.pixels);
+    queued.back().width = captured.width;
+    queued.back().height = captured.height;
+    queued.back().filename = captured.filename;
+    SDL_CondBroadcast(condition);
+    SDL_UnlockMutex(mutex);
+}
+
+void FrameCapture::stop()
+{
+    stopRecording();
+
+    if(running)
+    {
+        SDL_LockMutex(mutex);
+        running = false;
+        SDL_CondBroadcast(condition);
+        SDL_UnlockMutex(mutex);
+        if(writer)
+            SDL_WaitThread(writer, NULL);
+        writer = NULL;
+        free_pixels.clear();
+
+        SDL_DestroyCond(condition);
+        SDL_DestroyMutex(mutex);
+        condition = NULL;
+        mutex = NULL;
+
+        if(failed > 0)
+            rosalila()->utility->writeLogLine("Warning: "+rosalila()->utility->toString(failed)+" captured frames could not be written.");
+    }
+
+    for(int i=0;i<frame_capture_buffer_count;i++)
+    {
+        if(slots[i].buffer)
+            glDeleteBuffers(1, &slots[i].buffer);
+        slots[i].buffer = 0;
+        slots[i].buffer_size = 0;
+    }
+}
+
+int FrameCapture::threadFunction(void* data)
+{
+    ((FrameCapture*)data)->work();
+    return 0;
+}
+
+void FrameCapture::work()
+{
+    rosalila()->utility->tracer.setThreadName("RosalilaFrameCapture");
+    SDL_LockMutex(mutex);
+    while(true)
+    {
+        while(running && queued.empty())
+            SDL_CondWait(condition, mutex);
+        //Whatever was queued still gets written on stop
+        if(queued.empty())
+            break;
+
+        CapturedFrame captured;
+        captured.pixels.swap(queued.front().pixels);
+        captured.width = queued.front().width;
+        captured.height = queued.front().height;
+        captured.filename = queued.front().filename;
+        queued.pop_front();
+        SDL_UnlockMutex(mutex);
+
+        bool written = writeFrame(captured);
+
+        SDL_LockMutex(mutex);
+        if(written)
+            frames_written++;
+        else
+            failed++;
+        free_pixels.push_back(vector<unsigned char>());
+        free_pixels.back().swap(captured.pixels);
+        SDL_CondBroadcast(condition);
+    }
+    SDL_UnlockMutex(mutex);
+}
@@ -0,0 +1,130 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+FramePacer::FramePacer()
+{
+    frequency = 1;
+    next_frame = 0;
+    last_frame = 0;
+    vsync = VSYNC_OFF;
+    //SDL_Delay(1) sleeps at least a millisecond, the first measure replaces this
+    sleep_mean = 0.002;
+    sleep_variance = 0;
+    sleep_samples = 0;
+    tick_rate = 60;
+    tick_time = 1.0 / 60;
+    accumulator = 0;
+    max_ticks_per_frame = 8;
+    ticks_this_frame = 0;
+    frame_time = 0;
+    wait_time = 0;
+    late_frames = 0;
+}
+
+void FramePacer::init(double tick_rate)
+{
+    if(tick_rate <= 0)
+        tick_rate = 60;
+    this->tick_rate = tick_rate;
+    tick_time = 1.0 / tick_rate;
+    accumulator = 0;
+    frequency = SDL_GetPerformanceFrequency();
+    last_frame = SDL_GetPerformanceCounter();
+    next_frame = last_frame;
+}
+
+void FramePacer::setVsync(VsyncMode vsync)
+{
+    if(SDL_GL_SetSwapInterval((int)vsync) < 0)
+    {
+        if(vsync == VSYNC_ADAPTIVE)
+        {
+            rosalila()->utility->writeLogLine("Warning: Adaptive vsync is not supported, using vsync.");
+            setVsync(VSYNC_ON);
+            return;
+        }
+        if(vsync == VSYNC_ON)
+            rosalila()->utility->writeLogLine("Warning: Could not enable vsync.");
+        vsync = VSYNC_OFF;
+    }
+    this->vsync = vsync;
+}
+
+void FramePacer::wait(int fps)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 start = now;
+    if(fps > 0)
+    {
+        //Scheduled from the last due time and not from now so the frames do not drift
+        Uint64 period = frequency / fps;
+        next_frame += period;
+        if(now > next_frame + period)
+        {
+            next_frame = now;
+            late_frames++;
+        }
+        else if(now < next_frame)
+        {
+            waitUntil(next_frame);
+            now = SDL_GetPerformanceCounter();
+        }
+    }
+    else
+    {
+        next_frame = now;
+    }
+
+    wait_time = getSeconds(now - start);
+    frame_time = getSeconds(now - last_frame);
+    last_frame = now;
+
+    accumulator += frame_time;
+    if(accumulator > tick_time * max_ticks_per_frame)
+        accumulator = tick_time * max_ticks_per_frame;
+    ticks_this_frame = 0;
+}
+
+bool FramePacer::tick()
+{
+    if(accumulator < tick_time)
+        return false;
+    accumulator -= tick_time;
+    ticks_this_frame++;
+    return true;
+}
+
+double FramePacer::getInterpolation()
+{
+    return accumulator / tick_time;
+}
+
+double FramePacer::getSeconds(Uint64 counter)
+{
+    return (double)counter / (double)frequency;
+}
+
+void FramePacer::waitUntil(Uint64 counter)
+{
+    while(true)
+    {
+        Uint64 now = SDL_GetPerformanceCounter();
+        if(now >= counter)
+            return;
+        if(getSeconds(counter - now) <= sleep_mean + sqrt(sleep_variance))
+            break;
+
+        SDL_Delay(1);
+        double slept = getSeconds(SDL_GetPerformanceCounter() - now);
+        //Running mean and variance, capping the count keeps them following changes of the timer
+        if(sleep_samples < frame_pacer_max_sleep_samples)
+            sleep_samples++;
+        double weight = 1.0 / sleep_samples;
+        double delta = slept - sleep_mean;
+        sleep_mean += delta * weight;
+        sleep_variance = (1 - weight) * (sleep_variance + weight * delta * delta);
+    }
+
+    while(SDL_GetPerformanceCounter() < counter)
+    {
+    }
+}
@@ -0,0 +1,198 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+FrameStats::FrameStats()
+{
+    overlay = false;
+    draw_calls = 0;
+    vertices = 0;
+    texture_binds = 0;
+    texture_uploads = 0;
+    last_frame_draw_calls = 0;
+    last_frame_vertices = 0;
+    last_frame_texture_binds = 0;
+    last_frame_texture_uploads = 0;
+    use_timer_queries = false;
+    current_query = 0;
+    query_running = false;
+    last_gpu_time = 0;
+    for(int i=0;i<frame_stats_query_count;i++)
+    {
+        queries[i] = 0;
+        query_pending[i] = false;
+    }
+    for(int i=0;i<FRAME_STAT_COUNT;i++)
+        times[i] = 0;
+    next_sample = 0;
+    sample_count = 0;
+}
+
+void FrameStats::init(bool use_timer_queries, bool overlay)
+{
+#ifdef OSX
+    use_timer_queries = false;
+#endif
+    this->use_timer_queries = use_timer_queries;
+    this->overlay = overlay;
+    for(int i=0;i<FRAME_STAT_COUNT;i++)
+        samples[i].assign(frame_stats_window_size, 0.0f);
+    next_sample = 0;
+    sample_count = 0;
+
+#ifndef OSX
+    if(use_timer_queries)
+    {
+        glGenQueries(frame_stats_query_count, queries);
+        current_query = 0;
+        glBeginQuery(GL_TIME_ELAPSED, queries[current_query]);
+        query_running = true;
+    }
+#endif
+}
+
+Uint64 FrameStats::addTime(FrameStat stat, Uint64 start)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    times[stat] += (float)((now - start) * 1000.0 / SDL_GetPerformanceFrequency());
+    return now;
+}
+
+void FrameStats::endGpuFrame()
+{
+#ifndef OSX
+    if(use_timer_queries)
+    {
+        if(query_running)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            query_running = false;
+            query_pending[current_query] = true;
+            current_query = (current_query + 1) % frame_stats_query_count;
+        }
+        //Oldest first, results not there yet are not waited on and this frame goes without a query
+        for(int i=0;i<frame_stats_query_count;i++)
+        {
+            int query = (current_query + i) % frame_stats_query_count;
+            if(!query_pending[query])
+                continue;
+            GLuint available = 0;
+            glGetQueryObjectuiv(queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available)
+                break;
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(queries[query], GL_QUERY_RESULT, &elapsed);
+            last_gpu_time = (float)(elapsed / 1000000.0);
+            query_pending[query] = false;
+        }
+        if(!query_pending[current_query])
+        {
+            glBeginQuery(GL_TIME_ELAPSED, queries[current_query]);
+            query_running = true;
+        }
+    }
+#endif
+
+    last_frame_draw_calls = draw_calls;
+    last_frame_vertices = vertices;
+    last_frame_texture_binds = texture_binds;
+    last_frame_texture_uploads = texture_uploads;
+    draw_calls = 0;
+    vertices = 0;
+    texture_binds = 0;
+    texture_uploads = 0;
+}
+
+void FrameStats::endFrame(float frame_time)
+{
+    times[FRAME_STAT_FRAME_TIME] = frame_time;
+    times[FRAME_STAT_DRAW_CALLS] = (float)last_frame_draw_calls;
+    times[FRAME_STAT_VERTICES] = (float)last_frame_vertices;
+    times[FRAME_STAT_TEXTURE_BINDS] = (float)last_frame_texture_binds;
+    times[FRAME_STAT_TEXTURE_UPLOADS] = (float)last_frame_texture_uploads;
+    times[FRAME_STAT_GPU_TIME] = last_gpu_time;
+
+    for(int i=0;i<FRAME_STAT_COUNT;i++)
+    {
+        samples[i][next_sample] = times[i];
+        times[i] = 0;
+    }
+    next_sample = (next_sample + 1) % frame_stats_window_size;
+    if(sample_count < frame_stats_window_size)
+        sample_count++;
+
+    float average_frame_time = getSummary(FRAME_STAT_FRAME_TIME).average;
+    if(average_frame_time > 0)
+        rosalila()->graphics->current_fps = (int)(1000.0f / average_frame_time + 0.5f);
+}
+
+FrameStatSummary FrameStats::getSummary(FrameStat stat)
+{
+    FrameStatSummary summary;
+    summary.last = summary.min = summary.average = summary.p99 = 0;
+    if(sample_count == 0)
+        return summary;
+
+    vector<float> sorted(samples[stat].begin(), samples[stat].begin() + sample_count);
+    summary.last = samples[stat][(next_sample + frame_stats_window_size - 1) % frame_stats_window_size];
+    sort(sorted.begin(), sorted.end());
+    summary.min = sorted[0];
+    float total = 0;
+    for(int i=0;i<(int)sorted.size();i++)
+        total += sorted[i];
+    summary.average = total / sorted.size();
+    summary.p99 = sorted[(sorted.size() * 99 + 99) / 100 - 1];
+    return summary;
+}
+
+string FrameStats::getName(FrameStat stat)
+{
+    switch(stat)
+    {
+        case FRAME_STAT_FRAME_TIME: return "frame ms";
+        case FRAME_STAT_DRAW_CALLS: return "draw calls";
+        case FRAME_STAT_VERTICES: return "vertices";
+        case FRAME_STAT_TEXTURE_BINDS: return "texture binds";
+        case FRAME_STAT_TEXTURE_UPLOADS: return "texture uploads";
+        case FRAME_STAT_INPUTS_TIME: return "inputs ms";
+        case FRAME_STAT_GRAPHICS_TIME: return "graphics ms";
+        case FRAME_STAT_API_INTEGRATOR_TIME: return "api integrator ms";
+        case FRAME_STAT_SOUND_TIME: return "sound ms";
+        case FRAME_STAT_GPU_TIME: return "gpu ms";
+        default: return "";
+    }
+}
+
+vector<string> FrameStats::getOverlayLines()
+{
+    vector<string> lines;
+    lines.push_back("fps " + rosalila()->utility->toString(rosalila()->graphics->current_fps)
+                    + "   min / avg / p99");
+    for(int i=0;i<FRAME_STAT_COUNT;i++)
+    {
+        if(i == FRAME_STAT_GPU_TIME && !use_timer_queries)
+            continue;
+        FrameStatSummary summary = getSummary((FrameStat)i);
+        char line[96];
+        snprintf(line, sizeof(line), "%s  %.2f / %.2f / %.2f", getName((FrameStat)i).c_str(),
+                 summary.min, summary.average, summary.p99);
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+void FrameStats::stop()
+{
+#ifndef OSX
+    if(use_timer_queries && queries[0])
+    {
+        if(query_running)
+            glEndQuery(GL_TIME_ELAPSED);
+        query_running = false;
+        glDeleteQueries(frame_stats_query_count, queries);
+        for(int i=0;i<frame_stats_query_count;i++)
+        {
+            queries[i] = 0;
+            query_pending[i] = false;
+        }
+    }
+#endif
+}
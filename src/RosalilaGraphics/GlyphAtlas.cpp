@@ -0,0 +1,130 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+bool GlyphKey::operator<(const GlyphKey& other) const
+{
+    if(font != other.font)
+        return font < other.font;
+    if(size != other.size)
+        return size < other.size;
+    if(style != other.style)
+        return style < other.style;
+    if(outline != other.outline)
+        return outline < other.outline;
+    return codepoint < other.codepoint;
+}
+
+GlyphAtlas::GlyphAtlas()
+{
+    glyphs_rasterized = 0;
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+    for(map<GlyphKey, Glyph>::iterator i=glyphs.begin();i!=glyphs.end();i++)
+        delete i->second.image;
+}
+
+Uint32 GlyphAtlas::nextCodepoint(const string& text, int& index)
+{
+    unsigned char first = (unsigned char)text[index];
+    index++;
+
+    int continuation_bytes = 0;
+    Uint32 codepoint = first;
+    if(first >= 0xF0)
+    {
+        codepoint = first & 0x07;
+        continuation_bytes = 3;
+    }
+    else if(first >= 0xE0)
+    {
+        codepoint = first & 0x0F;
+        continuation_bytes = 2;
+    }
+    else if(first >= 0xC0)
+    {
+        codepoint = first & 0x1F;
+        continuation_bytes = 1;
+    }
+    else if(first >= 0x80)
+    {
+        //Stray continuation byte
+        return 0xFFFD;
+    }
+
+    for(int i=0;i<continuation_bytes;i++)
+    {
+        if(index >= (int)text.length() || ((unsigned char)text[index] & 0xC0) != 0x80)
+            return 0xFFFD;
+        codepoint = (codepoint << 6) | ((unsigned char)text[index] & 0x3F);
+        index++;
+    }
+    return codepoint;
+}
+
+Glyph* GlyphAtlas::getGlyph(TTF_Font* font, Uint32 codepoint)
+{
+    //SDL_ttf glyph functions only take 16 bits characters
+    if(codepoint > 0xFFFF)
+        codepoint = 0xFFFD;
+
+    GlyphKey key;
+    key.font = font;
+    key.size = TTF_FontHeight(font);
+    key.style = TTF_GetFontStyle(font);
+    key.outline = TTF_GetFontOutline(font);
+    key.codepoint = codepoint;
+
+    map<GlyphKey, Glyph>::iterator it = glyphs.find(key);
+    if(it != glyphs.end())
+        return &it->second;
+
+    Glyph glyph;
+    glyph.image = NULL;
+    glyph.offset_x = 0;
+    glyph.advance = 0;
+    glyph.index = TTF_GlyphIsProvided(font, (Uint16)codepoint);
+
+    int minx, maxx, miny, maxy;
+    if(TTF_GlyphMetrics(font, (Uint16)codepoint, &minx, &maxx, &miny, &maxy, &glyph.advance) == 0)
+    {
+        //Same placement SDL_ttf uses when the glyph starts the string
+        if(minx < 0)
+            glyph.offset_x = minx;
+
+        //Rendered in white, the text color is applied as the vertex color
+        char utf8[5] = {0, 0, 0, 0, 0};
+        if(codepoint < 0x80)
+        {
+            utf8[0] = (char)codepoint;
+        }
+        else if(codepoint < 0x800)
+        {
+            utf8[0] = (char)(0xC0 | (codepoint >> 6));
+            utf8[1] = (char)(0x80 | (codepoint & 0x3F));
+        }
+        else
+        {
+            utf8[0] = (char)(0xE0 | (codepoint >> 12));
+            utf8[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            utf8[2] = (char)(0x80 | (codepoint & 0x3F));
+        }
+
+        SDL_Color white = {255, 255, 255, 255};
+        SDL_Surface* surface = TTF_RenderUTF8_Blended(font, utf8, white);
+        if(surface)
+        {
+            GLenum texture_format = GL_RGBA;
+            if(surface->format->Rmask != 0x000000ff)
+                texture_format = GL_BGRA;
+            glyph.image = rosalila()->graphics->addToTextureAtlas(surface, texture_format);
+            if(!glyph.image)
+                rosalila()->utility->writeLogLine("Warning: Glyph "+rosalila()->utility->toString((int)codepoint)+" does not fit on the texture atlas.");
+            SDL_FreeSurface(surface);
+        }
+        glyphs_rasterized++;
+    }
+
+    glyphs[key] = glyph;
+    return &glyphs[key];
+}
@@ -0,0 +1,213 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+void GraphicsStateCache::init()
+{
+    changes_issued = 0;
+    changes_avoided = 0;
+    last_frame_changes_issued = 0;
+    last_frame_changes_avoided = 0;
+    projection_uniform = -1;
+    invalidate();
+}
+
+void GraphicsStateCache::invalidate()
+{
+    capabilities.clear();
+    bound_texture_known = false;
+    bound_texture = 0;
+    blend_function_known = false;
+    blend_source = GL_ONE;
+    blend_destination = GL_ZERO;
+    blend_separate_alpha = false;
+    color_known = false;
+    projection_known = false;
+    projection_width = 0;
+    projection_height = 0;
+    projection_bottom_up = false;
+    modelview_identity = false;
+    program_known = false;
+    program = 0;
+    framebuffer_known = false;
+    framebuffer = 0;
+}
+
+void GraphicsStateCache::enable(GLenum capability)
+{
+    map<GLenum,bool>::iterator it = capabilities.find(capability);
+    if(it != capabilities.end() && it->second)
+    {
+        changes_avoided++;
+        return;
+    }
+    glEnable(capability);
+    capabilities[capability] = true;
+    changes_issued++;
+}
+
+void GraphicsStateCache::disable(GLenum capability)
+{
+    map<GLenum,bool>::iterator it = capabilities.find(capability);
+    if(it != capabilities.end() && !it->second)
+    {
+        changes_avoided++;
+        return;
+    }
+    glDisable(capability);
+    capabilities[capability] = false;
+    changes_issued++;
+}
+
+void GraphicsStateCache::bindTexture(GLuint texture)
+{
+    if(bound_texture_known && bound_texture == texture)
+    {
+        changes_avoided++;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    rosalila()->graphics->frame_stats.texture_binds++;
+    bound_texture_known = true;
+    bound_texture = texture;
+    changes_issued++;
+}
+
+void GraphicsStateCache::deleteTexture(GLuint texture)
+{
+    //GL falls back to texture 0 and the name may be handed out again
+    if(bound_texture == texture)
+        bound_texture_known = false;
+    glDeleteTextures(1, &texture);
+}
+
+void GraphicsStateCache::bindFramebuffer(GLuint framebuffer)
+{
+    if(framebuffer_known && this->framebuffer == framebuffer)
+    {
+        changes_avoided++;
+        return;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    framebuffer_known = true;
+    this->framebuffer = framebuffer;
+    changes_issued++;
+}
+
+void GraphicsStateCache::deleteFramebuffer(GLuint framebuffer)
+{
+    //Deleting the bound framebuffer goes back to the screen
+    if(this->framebuffer == framebuffer)
+        framebuffer_known = false;
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+void GraphicsStateCache::blendFunction(GLenum source, GLenum destination)
+{
+    bool separate_alpha = framebuffer_known && framebuffer != 0;
+    if(blend_function_known && blend_source == source && blend_destination == destination
+       && blend_separate_alpha == separate_alpha)
+    {
+        changes_avoided++;
+        return;
+    }
+    if(separate_alpha)
+        glBlendFuncSeparate(source, destination, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    else
+        glBlendFunc(source, destination);
+    blend_function_known = true;
+    blend_separate_alpha = separate_alpha;
+    blend_source = source;
+    blend_destination = destination;
+    changes_issued++;
+}
+
+void GraphicsStateCache::color(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha)
+{
+    if(color_known && color_red == red && color_green == green && color_blue == blue && color_alpha == alpha)
+    {
+        changes_avoided++;
+        return;
+    }
+    glColor4ub(red, green, blue, alpha);
+    color_known = true;
+    color_red = red;
+    color_green = green;
+    color_blue = blue;
+    color_alpha = alpha;
+    changes_issued++;
+}
+
+void GraphicsStateCache::forgetColor()
+{
+    color_known = false;
+}
+
+void GraphicsStateCache::useProgram(GLuint program, GLint projection_uniform)
+{
+    if(program_known && this->program == program)
+    {
+        changes_avoided++;
+        return;
+    }
+    glUseProgram(program);
+    program_known = true;
+    this->program = program;
+    this->projection_uniform = projection_uniform;
+    projection_known = false;
+    changes_issued++;
+}
+
+void GraphicsStateCache::orthoProjection(int width, int height, bool bottom_up)
+{
+    if(projection_known && projection_width == width && projection_height == height && projection_bottom_up == bottom_up)
+    {
+        changes_avoided++;
+        return;
+    }
+    if(projection_uniform != -1)
+    {
+        //Same matrix glOrtho builds, column major
+        GLfloat projection[16] =
+        {
+            2.0f / width, 0, 0, 0,
+            0, (bottom_up ? 2.0f : -2.0f) / height, 0, 0,
+            0, 0, -1.0f, 0,
+            -1.0f, bottom_up ? -1.0f : 1.0f, 0, 1.0f
+        };
+        glUniformMatrix4fv(projection_uniform, 1, GL_FALSE, projection);
+    }
+    else
+    {
+        glMatrixMode( GL_PROJECTION );
+        glLoadIdentity();
+        if(bottom_up)
+            glOrtho(0.0f, width, 0.0f, height, -1.0f, 1.0f);
+        else
+            glOrtho(0.0f, width, height, 0.0f, -1.0f, 1.0f);
+        glMatrixMode( GL_MODELVIEW );
+    }
+    projection_known = true;
+    projection_width = width;
+    projection_height = height;
+    projection_bottom_up = bottom_up;
+    changes_issued++;
+}
+
+void GraphicsStateCache::loadModelviewIdentity()
+{
+    if(modelview_identity)
+    {
+        changes_avoided++;
+        return;
+    }
+    glLoadIdentity();
+    modelview_identity = true;
+    changes_issued++;
+}
+
+void GraphicsStateCache::endFrame()
+{
+    last_frame_changes_issued = changes_issued;
+    last_frame_changes_avoided = changes_avoided;
+    changes_issued = 0;
+    changes_avoided = 0;
+}
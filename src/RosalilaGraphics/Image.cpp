@@ -12,6 +12,15 @@ Image::Image()
     color_filter.green = 255;
     color_filter.blue = 255;
     color_filter.alpha = 255;
+    uv_x1 = 0;
+    uv_y1 = 0;
+    uv_x2 = 1;
+    uv_y2 = 1;
+    texture_atlas = NULL;
+    texture = 0;
+    ready = true;
+    failed = false;
+    framebuffer = 0;
 }
 
 int Image::getWidth()
@@ -46,5 +55,10 @@ void Image::setHeight(int height)
 
 Image::~Image()
 {
-    glDeleteTextures( 1, &texture );
+    if(framebuffer)
+        rosalila()->graphics->deleteFramebuffer( this );
+    //The atlas texture is shared with other images
+    if(texture_atlas || texture == 0)
+        return;
+    rosalila()->graphics->deleteTexture( texture );
 }
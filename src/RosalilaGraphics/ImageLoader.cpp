@@ -0,0 +1,190 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+//Runs on the worker threads, no log lines from here
+static void decodeImage(ImageLoadRequest& request)
+{
+    ROSALILA_TRACE("ImageLoader decodeImage");
+    if(!rosalila()->utility->fileExists(request.filename))
+    {
+        request.error = "The file does not exist.";
+        return;
+    }
+    request.surface = IMG_Load(request.filename.c_str());
+    if(!request.surface)
+        request.error = SDL_GetError();
+}
+
+ImageLoader::ImageLoader()
+{
+    thread_count = 0;
+    upload_budget = 4;
+    mutex = NULL;
+    condition = NULL;
+    running = false;
+    loading = 0;
+    failed = 0;
+}
+
+void ImageLoader::init(int thread_count, int upload_budget)
+{
+    if(thread_count <= 0)
+        thread_count = SDL_GetCPUCount() - 1;
+    if(thread_count < 1)
+        thread_count = 1;
+    this->thread_count = thread_count;
+    this->upload_budget = upload_budget;
+}
+
+Image* ImageLoader::load(string filename, bool use_texture_atlas, std::function<void(Image*)> callback)
+{
+    if(!running)
+    {
+        //SDL_image loads the codecs on the first IMG_Load otherwise, and that is not safe from several threads
+        int codecs = IMG_INIT_PNG | IMG_INIT_JPG;
+        if((IMG_Init(codecs) & codecs) != codecs)
+            rosalila()->utility->writeLogLine(std::string("Warning: Could not load every image codec. ")+IMG_GetError());
+
+        mutex = SDL_CreateMutex();
+        condition = SDL_CreateCond();
+        running = true;
+        for(int i=0;i<thread_count;i++)
+        {
+            SDL_Thread* thread = SDL_CreateThread(threadFunction, "RosalilaImageLoader", this);
+            if(thread)
+                threads.push_back(thread);
+        }
+        if(threads.empty())
+            rosalila()->utility->writeLogLine("Warning: Could not start the image loader threads, images will load on updateScreen.");
+        else
+            rosalila()->utility->writeLogLine("Image loader started with "+rosalila()->utility->toString((int)threads.size())+" threads");
+    }
+
+    Image* image = new Image();
+    image->ready = false;
+
+    ImageLoadRequest request;
+    request.filename = filename;
+    request.use_texture_atlas = use_texture_atlas;
+    request.image = image;
+    request.callback = callback;
+    request.surface = NULL;
+
+    SDL_LockMutex(mutex);
+    requests.push_back(request);
+    loading++;
+    SDL_CondSignal(condition);
+    SDL_UnlockMutex(mutex);
+
+    return image;
+}
+
+void ImageLoader::update()
+{
+    if(!running)
+        return;
+
+    //Without workers the main thread decodes, one image per frame
+    if(threads.empty())
+    {
+        SDL_LockMutex(mutex);
+        if(!requests.empty())
+        {
+            decodeImage(requests.front());
+            decoded.push_back(requests.front());
+            requests.pop_front();
+        }
+        SDL_UnlockMutex(mutex);
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 budget = (Uint64)upload_budget * SDL_GetPerformanceFrequency() / 1000;
+    while(true)
+    {
+        SDL_LockMutex(mutex);
+        if(decoded.empty())
+        {
+            SDL_UnlockMutex(mutex);
+            break;
+        }
+        ImageLoadRequest request = decoded.front();
+        decoded.pop_front();
+        SDL_UnlockMutex(mutex);
+
+        loading--;
+        if(request.surface)
+        {
+            rosalila()->graphics->uploadImage(request.image, request.surface, request.use_texture_atlas, request.filename);
+            SDL_FreeSurface(request.surface);
+            request.image->ready = true;
+            if(request.callback)
+                request.callback(request.image);
+        }
+        else
+        {
+            failed++;
+            rosalila()->utility->writeLogLine("Warning: "+request.filename+" could not be loaded. "+request.error);
+            //The image is never drawn, the callback still runs so the caller is not left waiting
+            request.image->failed = true;
+            if(request.callback)
+                request.callback(request.image);
+        }
+
+        if(SDL_GetPerformanceCounter() - start >= budget)
+            break;
+    }
+}
+
+void ImageLoader::stop()
+{
+    if(!running)
+        return;
+
+    SDL_LockMutex(mutex);
+    running = false;
+    SDL_CondBroadcast(condition);
+    SDL_UnlockMutex(mutex);
+    for(int i=0;i<(int)threads.size();i++)
+        SDL_WaitThread(threads[i], NULL);
+    threads.clear();
+
+    for(list<ImageLoadRequest>::iterator i=decoded.begin();i!=decoded.end();i++)
+        if(i->surface)
+            SDL_FreeSurface(i->surface);
+    requests.clear();
+    decoded.clear();
+    loading = 0;
+
+    SDL_DestroyCond(condition);
+    SDL_DestroyMutex(mutex);
+    condition = NULL;
+    mutex = NULL;
+}
+
+int ImageLoader::threadFunction(void* data)
+{
+    ((ImageLoader*)data)->work();
+    return 0;
+}
+
+void ImageLoader::work()
+{
+    rosalila()->utility->tracer.setThreadName("RosalilaImageLoader");
+    SDL_LockMutex(mutex);
+    while(true)
+    {
+        while(running && requests.empty())
+            SDL_CondWait(condition, mutex);
+        if(!running)
+            break;
+
+        ImageLoadRequest request = requests.front();
+        requests.pop_front();
+        SDL_UnlockMutex(mutex);
+
+        decodeImage(request);
+
+        SDL_LockMutex(mutex);
+        decoded.push_back(request);
+    }
+    SDL_UnlockMutex(mutex);
+}
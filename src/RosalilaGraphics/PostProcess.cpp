@@ -0,0 +1,192 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+static const char* pass_vertex_shader =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 corner;\n"
+    "out vec2 fragment_texture_coordinate;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);\n"
+    "    fragment_texture_coordinate = corner;\n"
+    "}\n";
+
+//The frame is drawn over black, fading its colors is the same as fading every draw
+static const char* effects_fragment_shader =
+    "#version 330 core\n"
+    "uniform sampler2D image;\n"
+    "uniform vec2 resolution;\n"
+    "uniform float saturation;\n"
+    "uniform float fade;\n"
+    "uniform vec2 offset;\n"
+    "in vec2 fragment_texture_coordinate;\n"
+    "out vec4 output_color;\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 coordinate = fragment_texture_coordinate - offset / resolution;\n"
+    "    if(coordinate.x < 0.0 || coordinate.y < 0.0 || coordinate.x > 1.0 || coordinate.y > 1.0)\n"
+    "    {\n"
+    "        output_color = vec4(0.0);\n"
+    "        return;\n"
+    "    }\n"
+    "    vec4 color = texture(image, coordinate);\n"
+    "    float grey = (color.r + color.g + color.b) / 3.0;\n"
+    "    color.rgb = mix(vec3(grey), color.rgb, saturation) * fade;\n"
+    "    output_color = color;\n"
+    "}\n";
+
+PostProcess::PostProcess()
+{
+    supported = false;
+    scene = NULL;
+    scene_active = false;
+    targets[0] = NULL;
+    targets[1] = NULL;
+    vertex_array = 0;
+    vertex_buffer = 0;
+}
+
+bool PostProcess::init(bool core_profile)
+{
+    supported = false;
+#ifndef OSX
+    if(!core_profile)
+        return false;
+    if(!effects_program.init(pass_vertex_shader, effects_fragment_shader))
+        return false;
+    effects_resolution_uniform = effects_program.getUniformLocation("resolution");
+    saturation_uniform = effects_program.getUniformLocation("saturation");
+    fade_uniform = effects_program.getUniformLocation("fade");
+    offset_uniform = effects_program.getUniformLocation("offset");
+
+    GLfloat corners[8] = {0, 0, 1, 0, 0, 1, 1, 1};
+    glGenVertexArrays(1, &vertex_array);
+    glBindVertexArray(vertex_array);
+    glGenBuffers(1, &vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid*)0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    supported = true;
+#endif
+    return supported;
+}
+
+int PostProcess::addPass(string fragment_source)
+{
+    if(!supported)
+        return -1;
+
+    RosalilaGraphics* graphics = rosalila()->graphics;
+    if(!targets[0])
+    {
+        targets[0] = graphics->createRenderTarget(graphics->screen_width, graphics->screen_height);
+        targets[1] = graphics->createRenderTarget(graphics->screen_width, graphics->screen_height);
+    }
+
+    PostProcessPass pass;
+    pass.program = new ShaderProgram();
+    bool compiled = false;
+    graphics->runOnRenderThread([&]()
+    {
+        compiled = pass.program->init(pass_vertex_shader, fragment_source);
+        pass.resolution_uniform = pass.program->getUniformLocation("resolution");
+        pass.time_uniform = pass.program->getUniformLocation("time");
+    });
+    if(!compiled)
+    {
+        delete pass.program;
+        return -1;
+    }
+    pass.enabled = true;
+
+    int index = (int)passes.size();
+    graphics->runOnRenderThread([&]()
+    {
+        passes.push_back(pass);
+    });
+    return index;
+}
+
+bool PostProcess::hasEffects(double saturation, double fade, int offset_x, int offset_y)
+{
+    return saturation != 1.0 || fade != 1.0 || offset_x != 0 || offset_y != 0;
+}
+
+bool PostProcess::isNeeded(double saturation, double fade, int offset_x, int offset_y)
+{
+    if(!supported)
+        return false;
+    if(hasEffects(saturation, fade, offset_x, offset_y))
+        return true;
+    for(int i=0;i<(int)passes.size();i++)
+        if(passes[i].enabled)
+            return true;
+    return false;
+}
+
+void PostProcess::render(float saturation, float fade, float offset_x, float offset_y)
+{
+#ifndef OSX
+    RosalilaGraphics* graphics = rosalila()->graphics;
+    GraphicsStateCache* state_cache = &graphics->state_cache;
+    float width = (float)graphics->screen_width;
+    float height = (float)graphics->screen_height;
+
+    //The effects pass also copies the scene when no other pass is enabled
+    vector<PostProcessPass*> chain;
+    bool effects = hasEffects(saturation, fade, (int)offset_x, (int)offset_y);
+    for(int i=0;i<(int)passes.size();i++)
+        if(passes[i].enabled)
+            chain.push_back(&passes[i]);
+    if(effects || chain.empty())
+        chain.insert(chain.begin(), (PostProcessPass*)NULL);
+
+    GLuint source = scene->texture;
+    for(int i=0;i<(int)chain.size();i++)
+    {
+        Image* target = i == (int)chain.size() - 1 ? NULL : targets[i % 2];
+        if(target)
+            graphics->bindRenderTarget(target->framebuffer, target->width, target->height, false);
+        else
+            graphics->bindRenderTarget(0, graphics->screen_width, graphics->screen_height, false);
+
+        if(!chain[i])
+        {
+            state_cache->useProgram(effects_program.program, -1);
+            glUniform2f(effects_resolution_uniform, width, height);
+            glUniform1f(saturation_uniform, saturation);
+            glUniform1f(fade_uniform, fade);
+            //Screen y goes down, texture y goes up
+            glUniform2f(offset_uniform, offset_x, -offset_y);
+        }
+        else
+        {
+            state_cache->useProgram(chain[i]->program->program, -1);
+            glUniform2f(chain[i]->resolution_uniform, width, height);
+            glUniform1f(chain[i]->time_uniform, SDL_GetTicks() / 1000.0f);
+        }
+        drawPass(source);
+
+        if(target)
+            source = target->texture;
+    }
+#endif
+}
+
+void PostProcess::drawPass(GLuint texture)
+{
+#ifndef OSX
+    RosalilaGraphics* graphics = rosalila()->graphics;
+    GraphicsStateCache* state_cache = &graphics->state_cache;
+    state_cache->disable(GL_BLEND);
+    state_cache->disable(GL_DEPTH_TEST);
+    state_cache->bindTexture(texture);
+    glBindVertexArray(vertex_array);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    graphics->frame_stats.draw_calls++;
+    graphics->frame_stats.vertices += 4;
+    glBindVertexArray(0);
+#endif
+}
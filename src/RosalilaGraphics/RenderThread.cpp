@@ -0,0 +1,310 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+void RenderFrame::clear()
+{
+    commands.clear();
+    vertices.clear();
+    instances.clear();
+    screenshots.clear();
+    deleted_textures.clear();
+    deleted_framebuffers.clear();
+}
+
+RenderThread::RenderThread()
+{
+    running = false;
+    thread = NULL;
+    mutex = NULL;
+    condition = NULL;
+    recording_frame = &frames[0];
+    submitted_frame = NULL;
+    pending_task = NULL;
+}
+
+bool RenderThread::start()
+{
+    RosalilaGraphics* graphics = rosalila()->graphics;
+
+    mutex = SDL_CreateMutex();
+    condition = SDL_CreateCond();
+    recording_frame = &frames[0];
+    submitted_frame = NULL;
+    pending_task = NULL;
+
+    //A context can only be current on one thread at a time
+    SDL_GL_MakeCurrent(graphics->window, NULL);
+    running = true;
+    thread = SDL_CreateThread(threadFunction, "RosalilaRender", this);
+    if(!thread)
+    {
+        running = false;
+        SDL_GL_MakeCurrent(graphics->window, graphics->gl_context);
+        SDL_DestroyCond(condition);
+        SDL_DestroyMutex(mutex);
+        condition = NULL;
+        mutex = NULL;
+        return false;
+    }
+    return true;
+}
+
+void RenderThread::stop()
+{
+    if(!running)
+        return;
+
+    RosalilaGraphics* graphics = rosalila()->graphics;
+
+    SDL_LockMutex(mutex);
+    running = false;
+    SDL_CondBroadcast(condition);
+    SDL_UnlockMutex(mutex);
+    SDL_WaitThread(thread, NULL);
+    thread = NULL;
+
+    SDL_GL_MakeCurrent(graphics->window, graphics->gl_context);
+
+    //Draws recorded after the last updateScreen are dropped, the textures still go away
+    for(int i=0;i<(int)recording_frame->deleted_textures.size();i++)
+        graphics->state_cache.deleteTexture(recording_frame->deleted_textures[i]);
+    for(int i=0;i<(int)recording_frame->deleted_framebuffers.size();i++)
+        graphics->state_cache.deleteFramebuffer(recording_frame->deleted_framebuffers[i]);
+    recording_frame->clear();
+
+    SDL_DestroyCond(condition);
+    SDL_DestroyMutex(mutex);
+    condition = NULL;
+    mutex = NULL;
+}
+
+void RenderThread::recordSprites(GLuint texture, GLenum blend_source, GLenum blend_destination,
+                                 const SpriteVertex* vertices, int count)
+{
+    RenderCommand command;
+    command.type = RENDER_COMMAND_SPRITES;
+    command.texture = texture;
+    command.blend_source = blend_source;
+    command.blend_destination = blend_destination;
+    command.first = (int)recording_frame->vertices.size();
+    command.count = count;
+    recording_frame->vertices.insert(recording_frame->vertices.end(), vertices, vertices + count);
+    recording_frame->commands.push_back(command);
+}
+
+void RenderThread::recordInstances(GLuint texture, GLenum blend_source, float width, float height,
+                                   float u1, float v1, float u2, float v2, bool flip,
+                                   float offset_x, float offset_y,
+                                   const SpriteInstance* instances, int count)
+{
+    RenderCommand command;
+    command.type = RENDER_COMMAND_INSTANCES;
+    command.texture = texture;
+    command.blend_source = blend_source;
+    command.first = (int)recording_frame->instances.size();
+    command.count = count;
+    command.width = width;
+    command.height = height;
+    command.u1 = u1;
+    command.v1 = v1;
+    command.u2 = u2;
+    command.v2 = v2;
+    command.flip = flip;
+    command.offset_x = offset_x;
+    command.offset_y = offset_y;
+    recording_frame->instances.insert(recording_frame->instances.end(), instances, instances + count);
+    recording_frame->commands.push_back(command);
+}
+
+void RenderThread::recordClear(Color color)
+{
+    RenderCommand command;
+    command.type = RENDER_COMMAND_CLEAR;
+    command.color = color;
+    recording_frame->commands.push_back(command);
+}
+
+void RenderThread::recordScreenshot(int x, int y, int w, int h, string filename)
+{
+    ScreenshotRequest screenshot;
+    screenshot.x = x;
+    screenshot.y = y;
+    screenshot.w = w;
+    screenshot.h = h;
+    screenshot.filename = filename;
+
+    RenderCommand command;
+    command.type = RENDER_COMMAND_SCREENSHOT;
+    command.first = (int)recording_frame->screenshots.size();
+    recording_frame->screenshots.push_back(screenshot);
+    recording_frame->commands.push_back(command);
+}
+
+void RenderThread::recordCapture(int x, int y, int w, int h, string filename)
+{
+    recordScreenshot(x, y, w, h, filename);
+    recording_frame->commands.back().type = RENDER_COMMAND_CAPTURE;
+}
+
+void RenderThread::recordRenderTarget(GLuint framebuffer, int width, int height, bool bottom_up)
+{
+    RenderCommand command;
+    command.type = RENDER_COMMAND_RENDER_TARGET;
+    command.texture = framebuffer;
+    command.width = width;
+    command.height = height;
+    command.flip = bottom_up;
+    recording_frame->commands.push_back(command);
+}
+
+void RenderThread::recordPostProcess(float saturation, float fade, float offset_x, float offset_y)
+{
+    RenderCommand command;
+    command.type = RENDER_COMMAND_POST_PROCESS;
+    command.u1 = saturation;
+    command.v1 = fade;
+    command.offset_x = offset_x;
+    command.offset_y = offset_y;
+    recording_frame->commands.push_back(command);
+}
+
+void RenderThread::recordTextureDelete(GLuint texture)
+{
+    recording_frame->deleted_textures.push_back(texture);
+}
+
+void RenderThread::recordFramebufferDelete(GLuint framebuffer)
+{
+    recording_frame->deleted_framebuffers.push_back(framebuffer);
+}
+
+void RenderThread::submitFrame()
+{
+    ROSALILA_TRACE("RenderThread::submitFrame");
+    SDL_LockMutex(mutex);
+    while(submitted_frame)
+        SDL_CondWait(condition, mutex);
+    submitted_frame = recording_frame;
+    //The render thread cleared the other frame after drawing it
+    recording_frame = recording_frame == &frames[0] ? &frames[1] : &frames[0];
+    SDL_CondBroadcast(condition);
+    SDL_UnlockMutex(mutex);
+}
+
+void RenderThread::runTask(std::function<void()> task)
+{
+    SDL_LockMutex(mutex);
+    pending_task = &task;
+    SDL_CondBroadcast(condition);
+    while(pending_task)
+        SDL_CondWait(condition, mutex);
+    SDL_UnlockMutex(mutex);
+}
+
+int RenderThread::threadFunction(void* data)
+{
+    ((RenderThread*)data)->loop();
+    return 0;
+}
+
+void RenderThread::loop()
+{
+    RosalilaGraphics* graphics = rosalila()->graphics;
+    SDL_GL_MakeCurrent(graphics->window, graphics->gl_context);
+    rosalila()->utility->tracer.setThreadName("RosalilaRenderThread");
+
+    SDL_LockMutex(mutex);
+    while(true)
+    {
+        //The frame was submitted before the task was asked for, it goes first
+        if(submitted_frame)
+        {
+            RenderFrame* frame = submitted_frame;
+            SDL_UnlockMutex(mutex);
+            render(frame);
+            SDL_LockMutex(mutex);
+            submitted_frame = NULL;
+            SDL_CondBroadcast(condition);
+        }
+        else if(pending_task)
+        {
+            std::function<void()>* task = pending_task;
+            SDL_UnlockMutex(mutex);
+            {
+                ROSALILA_TRACE("RenderThread task");
+                (*task)();
+            }
+            SDL_LockMutex(mutex);
+            pending_task = NULL;
+            SDL_CondBroadcast(condition);
+        }
+        else if(!running)
+        {
+            break;
+        }
+        else
+        {
+            SDL_CondWait(condition, mutex);
+        }
+    }
+    SDL_UnlockMutex(mutex);
+
+    SDL_GL_MakeCurrent(graphics->window, NULL);
+}
+
+void RenderThread::render(RenderFrame* frame)
+{
+    ROSALILA_TRACE("RenderThread::render");
+    RosalilaGraphics* graphics = rosalila()->graphics;
+
+    for(int i=0;i<(int)frame->commands.size();i++)
+    {
+        RenderCommand& command = frame->commands[i];
+        switch(command.type)
+        {
+            case RENDER_COMMAND_SPRITES:
+                graphics->sprite_batch.renderVertices(command.texture, command.blend_source, command.blend_destination,
+                                                      &frame->vertices[command.first], command.count);
+                break;
+            case RENDER_COMMAND_INSTANCES:
+                graphics->sprite_batch.renderInstances(command.texture, command.blend_source, command.width, command.height,
+                                                       command.u1, command.v1, command.u2, command.v2, command.flip,
+                                                       command.offset_x, command.offset_y,
+                                                       &frame->instances[command.first], command.count);
+                break;
+            case RENDER_COMMAND_CLEAR:
+                graphics->clearColorBuffer(command.color);
+                break;
+            case RENDER_COMMAND_SCREENSHOT:
+            {
+                ScreenshotRequest& screenshot = frame->screenshots[command.first];
+                graphics->saveScreenshot(screenshot.x, screenshot.y, screenshot.w, screenshot.h, screenshot.filename);
+                break;
+            }
+            case RENDER_COMMAND_RENDER_TARGET:
+                graphics->bindRenderTarget(command.texture, (int)command.width, (int)command.height, command.flip);
+                break;
+            case RENDER_COMMAND_POST_PROCESS:
+                graphics->post_process.render(command.u1, command.v1, command.offset_x, command.offset_y);
+                break;
+            case RENDER_COMMAND_CAPTURE:
+            {
+                ScreenshotRequest& screenshot = frame->screenshots[command.first];
+                graphics->frame_capture.capture(screenshot.x, screenshot.y, screenshot.w, screenshot.h, screenshot.filename);
+                break;
+            }
+        }
+    }
+
+    ROSALILA_TRACE("SDL_GL_SwapWindow");
+    graphics->frame_capture.endFrame();
+    SDL_GL_SwapWindow(graphics->window);
+    graphics->state_cache.endFrame();
+    graphics->frame_stats.endGpuFrame();
+
+    for(int i=0;i<(int)frame->deleted_textures.size();i++)
+        graphics->state_cache.deleteTexture(frame->deleted_textures[i]);
+    for(int i=0;i<(int)frame->deleted_framebuffers.size();i++)
+        graphics->state_cache.deleteFramebuffer(frame->deleted_framebuffers[i]);
+
+    frame->clear();
+}
@@ -5,18 +5,34 @@ RosalilaGraphics::RosalilaGraphics()
 
 }
 
+//Sidecar layout: magic, then version, png size, width, height, space, new line space,
+//two reserved values and the 256 x, y, w, h rectangles, all 32 bits
+static const char image_font_metrics_magic[4] = {'R', 'F', 'N', 'T'};
+static const Sint32 image_font_metrics_version = 1;
+static const int image_font_metrics_values = 8 + 256 * 4;
+
+static Sint32 getFileSize(std::string path)
+{
+    ifstream file(path.c_str(), ios::in | ios::binary | ios::ate);
+    if(!file.is_open())
+        return -1;
+    return (Sint32)file.tellg();
+}
+
 void RosalilaGraphics::initImageFont()
 {
     rosalila()->utility->writeLogLine("Setting up image font");
     this->image_font = NULL;
     Node* root_node = rosalila()->parser->getNodes(CONFIG_FILE_PATH);
     Node* image_font_node = root_node->getNodeByName("image_font");
+    std::string path;
     if(image_font_node)
     {
         if(image_font_node->hasAttribute("path"))
         {
             std::cout<<"Image font path: "<<image_font_node->attributes["path"]<<endl;
-            this->image_font = this->getImage(assets_directory + image_font_node->attributes["path"]);
+            path = assets_directory + image_font_node->attributes["path"];
+            this->image_font = this->getImage(path);
         }
     }
 
@@ -26,141 +42,197 @@ void RosalilaGraphics::initImageFont()
         return;
     }
 
-    GLubyte* pixels = new GLubyte[this->image_font->width*this->image_font->height*4];
-    glBindTexture(GL_TEXTURE_2D, this->image_font->texture);
-    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    if(loadImageFontMetrics(path))
+    {
+        rosalila()->utility->writeLogLine("Image font metrics loaded from "+path+".metrics");
+        return;
+    }
 
-    //Set the cell dimensions
-    int cellW = this->image_font->width / 16;
-    int cellH = this->image_font->height / 16;
+    if(!scanImageFontMetrics(path))
+    {
+        //Whole cells, better than nothing
+        int cellW = this->image_font->width / 16;
+        int cellH = this->image_font->height / 16;
+        for( int i = 0; i < 256; ++i )
+        {
+            image_font_character_rectangles[ i ].x = cellW * ( i % 16 );
+            image_font_character_rectangles[ i ].y = cellH * ( i / 16 );
+            image_font_character_rectangles[ i ].w = cellW;
+            image_font_character_rectangles[ i ].h = cellH;
+        }
+        this->image_font_space = cellW / 2;
+        this->image_font_new_line_space = cellH;
+        return;
+    }
 
-    //New line variables
-    int top = cellH;
-    int baseA = cellH;
+    saveImageFontMetrics(path);
+}
 
-    int currentChar = 0;
+bool RosalilaGraphics::loadImageFontMetrics(std::string path)
+{
+    ifstream file((path+".metrics").c_str(), ios::in | ios::binary);
+    if(!file.is_open())
+        return false;
+
+    char magic[4];
+    Sint32 values[image_font_metrics_values];
+    file.read(magic, sizeof(magic));
+    file.read((char*)values, sizeof(values));
+    if(!file || memcmp(magic, image_font_metrics_magic, sizeof(magic)) != 0)
+    {
+        rosalila()->utility->writeLogLine("Warning: "+path+".metrics is not a metrics file");
+        return false;
+    }
 
-    //Go through the cell rows
-    for( int rows = 0; rows < 16; ++rows )
+    //Outdated if the png changed
+    if(values[0] != image_font_metrics_version
+       || values[1] != getFileSize(path)
+       || values[2] != this->image_font->width
+       || values[3] != this->image_font->height)
     {
-        //Go through the cell columns
-        for( int cols = 0; cols < 16; ++cols )
-        {
-            //Set the character offset
-            image_font_character_rectangles[ currentChar ].x = cellW * cols;
-            image_font_character_rectangles[ currentChar ].y = cellH * rows;
+        rosalila()->utility->writeLogLine("Warning: "+path+".metrics is outdated");
+        return false;
+    }
 
-            //Set the dimensions of the character
-            image_font_character_rectangles[ currentChar ].w = cellW;
-            image_font_character_rectangles[ currentChar ].h = cellH;
+    this->image_font_space = values[4];
+    this->image_font_new_line_space = values[5];
+    Sint32* rectangles = &values[8];
+    for( int i = 0; i < 256; ++i )
+    {
+        image_font_character_rectangles[ i ].x = rectangles[ i*4 + 0 ];
+        image_font_character_rectangles[ i ].y = rectangles[ i*4 + 1 ];
+        image_font_character_rectangles[ i ].w = rectangles[ i*4 + 2 ];
+        image_font_character_rectangles[ i ].h = rectangles[ i*4 + 3 ];
+    }
+    return true;
+}
 
-            //Find Left Side
-            //Go through pixel columns
-            for( int pCol = 0; pCol < cellW; ++pCol )
-            {
-                //Go through pixel rows
-                for( int pRow = 0; pRow < cellH; ++pRow )
-                {
-                    //Get the pixel offsets
-                    int pX = ( cellW * cols ) + pCol;
-                    int pY = ( cellH * rows ) + pRow;
-
-                    size_t row = pRow * 256;
-                    size_t col = pCol * 4;
-
-                    //If a non colorkey pixel is found
-                    if( pixels[row + col + 0] )
-                    {
-                        //Set the x offset
-                        image_font_character_rectangles[ currentChar ].x = pX;
-
-                        //Break the loops
-                        pCol = cellW;
-                        pRow = cellH;
-                    }
-                }
-            }
+void RosalilaGraphics::saveImageFontMetrics(std::string path)
+{
+    Sint32 values[image_font_metrics_values];
+    values[0] = image_font_metrics_version;
+    values[1] = getFileSize(path);
+    values[2] = this->image_font->width;
+    values[3] = this->image_font->height;
+    values[4] = this->image_font_space;
+    values[5] = this->image_font_new_line_space;
+    values[6] = 0;
+    values[7] = 0;
+    Sint32* rectangles = &values[8];
+    for( int i = 0; i < 256; ++i )
+    {
+        rectangles[ i*4 + 0 ] = image_font_character_rectangles[ i ].x;
+        rectangles[ i*4 + 1 ] = image_font_character_rectangles[ i ].y;
+        rectangles[ i*4 + 2 ] = image_font_character_rectangles[ i ].w;
+        rectangles[ i*4 + 3 ] = image_font_character_rectangles[ i ].h;
+    }
 
-            //Find Right Side
-            //Go through pixel columns
-            for( int pColW = cellW - 1; pColW >= 0; --pColW )
-            {
-                //Go through pixel rows
-                for( int pRowW = 0; pRowW < cellH; ++pRowW )
-                {
-                    //Get the pixel offsets
-                    int pX = ( cellW * cols ) + pColW;
-                    int pY = ( cellH * rows ) + pRowW;
-
-                    //If a non colorkey pixel is found
-                    if( pixels[pX+pY+3] )
-                    {
-                        //Set the width
-                        image_font_character_rectangles[ currentChar ].w = ( pX - image_font_character_rectangles[ currentChar ].x ) + 1;
-
-                        //Break the loops
-                        pColW = -1;
-                        pRowW = cellH;
-                    }
-                }
-            }
+    ofstream file((path+".metrics").c_str(), ios::out | ios::binary | ios::trunc);
+    file.write(image_font_metrics_magic, sizeof(image_font_metrics_magic));
+    file.write((char*)values, sizeof(values));
+    if(!file)
+    {
+        rosalila()->utility->writeLogLine("Warning: Could not write "+path+".metrics, the image font will be scanned again on the next start");
+        return;
+    }
+    rosalila()->utility->writeLogLine("Image font metrics saved on "+path+".metrics");
+}
 
-            //Find Top
-            //Go through pixel rows
-            for( int pRow = 0; pRow < cellH; ++pRow )
-            {
-                //Go through pixel columns
-                for( int pCol = 0; pCol < cellW; ++pCol )
-                {
-                    //Get the pixel offsets
-                    int pX = ( cellW * cols ) + pCol;
-                    int pY = ( cellH * rows ) + pRow;
-
-                    //If a non colorkey pixel is found
-                    if( pixels[pX+pY+3] )
-                    {
-                        //If new top is found
-                        if( pRow < top )
-                        {
-                            top = pRow;
-                        }
-
-                        //Break the loops
-                        pCol = cellW;
-                        pRow = cellH;
-                    }
-                }
-            }
+bool RosalilaGraphics::scanImageFontMetrics(std::string path)
+{
+    //Read from the file instead of downloading the texture back from the GPU
+    SDL_Surface* surface = IMG_Load(path.c_str());
+    if(!surface)
+        return false;
+    if(surface->format->BytesPerPixel != 4 || surface->format->Amask == 0)
+    {
+        rosalila()->utility->writeLogLine("Warning: "+path+" has no alpha channel, glyph bounds can not be found");
+        SDL_FreeSurface(surface);
+        return false;
+    }
 
-            //Find Bottom of A
-            if( currentChar == 'A' )
-            {
-                //Go through pixel rows
-                for( int pRow = cellH - 1; pRow >= 0; --pRow )
-                {
-                    //Go through pixel columns
-                    for( int pCol = 0; pCol < cellW; ++pCol )
-                    {
-                        //Get the pixel offsets
-                        int pX = ( cellW * cols ) + pCol;
-                        int pY = ( cellH * rows ) + pRow;
-
-                        //If a non colorkey pixel is found
-                        if( pixels[pX+pY+3] )
-                        {
-                            //Bottom of a is found
-                            baseA = pRow;
-
-                            //Break the loops
-                            pCol = cellW;
-                            pRow = -1;
-                        }
-                    }
-                }
-            }
+    int alpha_byte = 0;
+    while((surface->format->Amask >> (alpha_byte * 8)) != 0xff)
+        alpha_byte++;
+
+    int width = surface->w;
+    int height = surface->h;
+
+    //Set the cell dimensions
+    int cellW = width / 16;
+    int cellH = height / 16;
+
+    //One pass over the pixels: which columns of every cell row and which rows of every
+    //cell column have something on them. The OR loops have no branches so they vectorize.
+    vector<Uint8> used_columns(16 * width, 0);
+    vector<Uint8> used_rows(16 * height, 0);
+    vector<Uint8> alpha_row(width);
+    for( int y = 0; y < cellH * 16; ++y )
+    {
+        Uint8* pixels = (Uint8*)surface->pixels + y * surface->pitch + alpha_byte;
+        for( int x = 0; x < width; ++x )
+            alpha_row[ x ] = pixels[ x * 4 ];
 
-            //Go to the next character
-            ++currentChar;
+        Uint8* columns = &used_columns[ ( y / cellH ) * width ];
+        for( int x = 0; x < width; ++x )
+            columns[ x ] |= alpha_row[ x ];
+
+        for( int cols = 0; cols < 16; ++cols )
+        {
+            Uint8 used = 0;
+            Uint8* cell_alpha = &alpha_row[ cellW * cols ];
+            for( int pCol = 0; pCol < cellW; ++pCol )
+                used |= cell_alpha[ pCol ];
+            used_rows[ cols * height + y ] = used;
+        }
+    }
+    SDL_FreeSurface(surface);
+
+    //New line variables
+    int top = cellH;
+    int baseA = cellH;
+
+    for( int currentChar = 0; currentChar < 256; ++currentChar )
+    {
+        int rows = currentChar / 16;
+        int cols = currentChar % 16;
+        Uint8* columns = &used_columns[ rows * width + cellW * cols ];
+        Uint8* cell_rows = &used_rows[ cols * height + cellH * rows ];
+
+        //Empty cells keep the whole cell
+        image_font_character_rectangles[ currentChar ].x = cellW * cols;
+        image_font_character_rectangles[ currentChar ].y = cellH * rows;
+        image_font_character_rectangles[ currentChar ].w = cellW;
+        image_font_character_rectangles[ currentChar ].h = cellH;
+
+        //Find Left Side
+        int left = 0;
+        while( left < cellW && !columns[ left ] )
+            ++left;
+        if( left == cellW )
+            continue;
+
+        //Find Right Side
+        int right = cellW - 1;
+        while( !columns[ right ] )
+            --right;
+
+        image_font_character_rectangles[ currentChar ].x = cellW * cols + left;
+        image_font_character_rectangles[ currentChar ].w = right - left + 1;
+
+        //Find Top
+        int pRow = 0;
+        while( !cell_rows[ pRow ] )
+            ++pRow;
+        if( pRow < top )
+            top = pRow;
+
+        //Find Bottom of A
+        if( currentChar == 'A' )
+        {
+            baseA = cellH - 1;
+            while( !cell_rows[ baseA ] )
+                --baseA;
         }
     }
 
@@ -176,6 +248,7 @@ void RosalilaGraphics::initImageFont()
         image_font_character_rectangles[ i ].y += top;
         image_font_character_rectangles[ i ].h -= top;
     }
+    return true;
 }
 
 void RosalilaGraphics::drawText( int x, int y, std::string text )
@@ -225,12 +298,79 @@ void RosalilaGraphics::init()
     screen_height=atoi(resolution_node->attributes["y"].c_str());
 
     Node* screen_size_node = root_node->getNodeByName("screen_size");
-    int screen_resized_width=atoi(screen_size_node->attributes["x"].c_str());
-    int screen_resized_height=atoi(screen_size_node->attributes["y"].c_str());
+    screen_resized_width=atoi(screen_size_node->attributes["x"].c_str());
+    screen_resized_height=atoi(screen_size_node->attributes["y"].c_str());
+    render_target = NULL;
+    target_framebuffer = 0;
+    target_width = screen_width;
+    target_height = screen_height;
+    target_bottom_up = false;
 
     Node* fullscreen_node = root_node->getNodeByName("fullscreen");
     fullscreen=fullscreen_node->attributes["enabled"]=="yes";
 
+    core_profile = true;
+    bool render_thread_enabled = false;
+    bool sort_draws = false;
+    Node* renderer_node = root_node->getNodeByName("renderer");
+    if(renderer_node && renderer_node->hasAttribute("core_profile"))
+        core_profile = renderer_node->attributes["core_profile"]=="yes";
+    if(renderer_node && renderer_node->hasAttribute("render_thread"))
+        render_thread_enabled = renderer_node->attributes["render_thread"]=="yes";
+    if(renderer_node && renderer_node->hasAttribute("sort_draws"))
+        sort_draws = renderer_node->attributes["sort_draws"]=="yes";
+    headless = false;
+    if(renderer_node && renderer_node->hasAttribute("headless"))
+        headless = renderer_node->attributes["headless"]=="yes";
+    if(headless)
+        fullscreen = false;
+#ifdef OSX
+    if(core_profile)
+    {
+        rosalila()->utility->writeLogLine("Warning: The core profile renderer is not supported on OSX, using the fixed function pipeline.");
+        core_profile = false;
+    }
+#endif
+
+    texture_atlas_enabled = false;
+    texture_atlas_size = 2048;
+    texture_atlas_max_image_size = 256;
+    Node* texture_atlas_node = root_node->getNodeByName("texture_atlas");
+    if(texture_atlas_node)
+    {
+        texture_atlas_enabled = texture_atlas_node->attributes["enabled"]=="yes";
+        if(texture_atlas_node->hasAttribute("size"))
+            texture_atlas_size = atoi(texture_atlas_node->attributes["size"].c_str());
+        if(texture_atlas_node->hasAttribute("max_image_size"))
+            texture_atlas_max_image_size = atoi(texture_atlas_node->attributes["max_image_size"].c_str());
+    }
+
+    bool text_cache_enabled = false;
+    int text_cache_max_memory = 8*1024*1024;
+    int text_cache_min_length = 32;
+    Node* text_cache_node = root_node->getNodeByName("text_cache");
+    if(text_cache_node)
+    {
+        text_cache_enabled = text_cache_node->attributes["enabled"]=="yes";
+        if(text_cache_node->hasAttribute("max_memory"))
+            text_cache_max_memory = atoi(text_cache_node->attributes["max_memory"].c_str());
+        if(text_cache_node->hasAttribute("min_length"))
+            text_cache_min_length = atoi(text_cache_node->attributes["min_length"].c_str());
+    }
+    text_cache.init(text_cache_enabled, text_cache_max_memory, text_cache_min_length);
+
+    int image_loader_threads = 0;
+    int image_loader_upload_budget = 4;
+    Node* image_loader_node = root_node->getNodeByName("image_loader");
+    if(image_loader_node)
+    {
+        if(image_loader_node->hasAttribute("threads"))
+            image_loader_threads = atoi(image_loader_node->attributes["threads"].c_str());
+        if(image_loader_node->hasAttribute("upload_budget"))
+            image_loader_upload_budget = atoi(image_loader_node->attributes["upload_budget"].c_str());
+    }
+    image_loader.init(image_loader_threads, image_loader_upload_budget);
+
     //Internal initializations
     joystick_1 = NULL;
     joystick_2 = NULL;
@@ -300,9 +440,39 @@ void RosalilaGraphics::init()
     SDL_GL_SetAttribute( SDL_GL_DOUBLEBUFFER, 1 ); // *new*
 
     rosalila()->utility->writeLogLine("Windowed or fullscreen setup stuff");
+    Uint32 window_flags = SDL_WINDOW_OPENGL | (headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN);
     window = SDL_CreateWindow( "Rosalila Framework", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
                                screen_resized_width, screen_resized_height,
-                               SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN );
+                               window_flags );
+    if(!window && headless)
+    {
+        //SDL older than 2.0.12 has no offscreen driver, a hidden window still works under Xvfb.
+        //An empty SDL_VIDEODRIVER is not the same as none on every SDL version, a driver is named instead.
+        string video_driver = previous_video_driver;
+        if(video_driver == "offscreen")
+            video_driver = "";
+        for(int i=0;video_driver == "" && i<SDL_GetNumVideoDrivers();i++)
+        {
+            string name = SDL_GetVideoDriver(i);
+            if(name != "offscreen" && name != "dummy")
+                video_driver = name;
+        }
+
+        SDL_QuitSubSystem(SDL_INIT_VIDEO);
+        SDL_ClearError();
+        if(video_driver != "")
+        {
+            rosalila()->utility->writeLogLine("Warning: Could not create an offscreen window, using a hidden window on the "+video_driver+" video driver.");
+            SDL_setenv("SDL_VIDEODRIVER", video_driver.c_str(), 1);
+            window = SDL_CreateWindow( "Rosalila Framework", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                                       screen_resized_width, screen_resized_height,
+                                       window_flags );
+        }
+        else
+        {
+            rosalila()->utility->writeLogLine("Error: Could not create an offscreen window and there is no other video driver.");
+        }
+    }
     if(!window)
     {
         //rosalila()->utility->writeLogLine("Could not init window");
@@ -312,15 +482,25 @@ void RosalilaGraphics::init()
         SDL_SetWindowFullscreen(window,SDL_WINDOW_FULLSCREEN);
 
     rosalila()->utility->writeLogLine("More GL stuff");
-    SDL_GL_CreateContext(window);
+    if(core_profile && !createContext(true))
+    {
+        rosalila()->utility->writeLogLine("Warning: Could not create an OpenGL 3.3 core profile context, using the fixed function pipeline.");
+        core_profile = false;
+    }
+    if(!core_profile)
+        createContext(false);
     GLenum error = GL_NO_ERROR;
     error = glGetError();
     if( error != GL_NO_ERROR ) {
          exit(12);
     }
 
-    #ifndef OSX
-        //glewInit();
+    #ifdef WINDOWS
+        //Needed to get the core profile entry points
+        glewExperimental = GL_TRUE;
+        glewInit();
+        //glewInit may leave an error behind
+        glGetError();
     #endif
 
     rosalila()->utility->writeLogLine("GL flags setup");
@@ -339,20 +519,69 @@ void RosalilaGraphics::init()
     rosalila()->utility->writeLogLine("GL flags setupB");
     glClear( GL_COLOR_BUFFER_BIT );
 
-    glMatrixMode( GL_PROJECTION );
-    glLoadIdentity();
+    state_cache.init();
+    texture_uploader.init(core_profile);
+    frame_capture.init(core_profile);
 
     rosalila()->utility->writeLogLine("GL flags setupC");
-    glOrtho(0.0f, screen_width, screen_height, 0.0f, -1.0f, 1.0f);
-
-    glMatrixMode( GL_MODELVIEW );
-    glLoadIdentity();
+    //On the core profile the projection is a uniform set on the first draw
+    if(!core_profile)
+    {
+        state_cache.orthoProjection(screen_width, screen_height);
+        state_cache.loadModelviewIdentity();
+    }
 
     rosalila()->utility->writeLogLine("GL flags setupD");
+    if(!sprite_batch.init(core_profile))
+        rosalila()->utility->writeLogLine("Error: Could not build the sprite shaders.");
+    sprite_batch.setSortDraws(sort_draws);
+    draw_saturation = 1.0;
+    draw_fade = 1.0;
+    draw_offset_x = 0;
+    draw_offset_y = 0;
+    if(post_process.init(core_profile))
+        rosalila()->utility->writeLogLine("Effects are done on a post process");
+    if(core_profile)
+        rosalila()->utility->writeLogLine("Using the OpenGL 3.3 core profile renderer");
+    else
+        rosalila()->utility->writeLogLine("Using the fixed function renderer");
+
     //Fps cap
     frames_per_seccond = 60;
     frame = 0;
     last_tick=SDL_GetTicks();
+    VsyncMode vsync = VSYNC_OFF;
+    double tick_rate = 60;
+    Node* frame_pacing_node = root_node->getNodeByName("frame_pacing");
+    if(frame_pacing_node)
+    {
+        if(frame_pacing_node->attributes["vsync"]=="yes")
+            vsync = VSYNC_ON;
+        if(frame_pacing_node->attributes["vsync"]=="adaptive")
+            vsync = VSYNC_ADAPTIVE;
+        //With vsync the display paces the frames unless asked otherwise
+        if(vsync != VSYNC_OFF)
+            frames_per_seccond = 0;
+        if(frame_pacing_node->hasAttribute("fps"))
+            frames_per_seccond = atoi(frame_pacing_node->attributes["fps"].c_str());
+        if(frame_pacing_node->hasAttribute("tick_rate"))
+            tick_rate = atof(frame_pacing_node->attributes["tick_rate"].c_str());
+    }
+    frame_pacer.init(tick_rate);
+    if(vsync != VSYNC_OFF && !headless)
+        frame_pacer.setVsync(vsync);
+
+    bool stats_overlay = false;
+    bool stats_gpu_time = false;
+    Node* stats_node = root_node->getNodeByName("stats");
+    if(stats_node)
+    {
+        stats_overlay = stats_node->attributes["overlay"]=="yes";
+        stats_gpu_time = stats_node->attributes["gpu_time"]=="yes";
+    }
+    if(stats_gpu_time && !core_profile)
+        rosalila()->utility->writeLogLine("Warning: The GPU time is only measured on the core profile renderer.");
+    frame_stats.init(stats_gpu_time && core_profile, stats_overlay);
 
     rosalila()->utility->writeLogLine("Setting up inputs");
     //Init joystickss
@@ -409,219 +638,413 @@ void RosalilaGraphics::init()
 
     initImageFont();
 
+    if(render_thread_enabled)
+    {
+        if(render_thread.start())
+            rosalila()->utility->writeLogLine("Rendering on its own thread");
+        else
+            rosalila()->utility->writeLogLine("Warning: Could not start the render thread, rendering on the main thread.");
+    }
+
     rosalila()->utility->writeLogLine("Graphics initialization finished");
 }
 
+bool RosalilaGraphics::createContext(bool core_profile)
+{
+    if(core_profile)
+    {
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    }
+    else
+    {
+        //SDL defaults
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, 0);
+    }
+    gl_context = SDL_GL_CreateContext(window);
+    return gl_context != NULL;
+}
+
 RosalilaGraphics::~RosalilaGraphics()
 {
+    image_loader.stop();
+    render_thread.stop();
+    frame_capture.stop();
+    frame_stats.stop();
     //Quit SDL
     SDL_Quit();
 }
 
 
-Image* RosalilaGraphics::getImage(std::string filename)
+void RosalilaGraphics::runOnRenderThread(std::function<void()> task)
 {
-    if(!rosalila()->utility->fileExists(filename))
+    if(render_thread.running)
+        render_thread.runTask(task);
+    else
+        task();
+}
+
+void RosalilaGraphics::deleteTexture(GLuint texture)
+{
+    if(render_thread.running)
     {
-        rosalila()->utility->writeLogLine("Warning: "+ filename+ " does not exist. Image could not be loaded.");        
+        render_thread.recordTextureDelete(texture);
+        return;
+    }
+    //Quads waiting on the batch still need this texture, sorted quads may use any texture
+    if(sprite_batch.current_texture == texture || !sprite_batch.sort_keys.empty())
+        sprite_batch.flush();
+    state_cache.deleteTexture(texture);
+}
+
+void RosalilaGraphics::deleteFramebuffer(Image* target)
+{
+    if(render_target == target)
+        setRenderTarget(NULL);
+    if(render_thread.running)
+        render_thread.recordFramebufferDelete(target->framebuffer);
+    else
+        state_cache.deleteFramebuffer(target->framebuffer);
+    target->framebuffer = 0;
+}
+
+Image* RosalilaGraphics::createRenderTarget(int width, int height)
+{
+    Image* image = new Image();
+    bool complete = false;
+    runOnRenderThread([&]()
+    {
+        image->texture = texture_uploader.createTexture(width, height, GL_RGBA, GL_RGBA, NULL, width * 4, GL_LINEAR);
+        glGenFramebuffers(1, &image->framebuffer);
+        state_cache.bindFramebuffer(image->framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, image->texture, 0);
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if(complete)
+            clearColorBuffer(Color(0, 0, 0, 0));
+        state_cache.bindFramebuffer(target_framebuffer);
+    });
+    if(!complete)
+    {
+        rosalila()->utility->writeLogLine("Warning: Could not create a "+rosalila()->utility->toString(width)+"x"+rosalila()->utility->toString(height)+" render target.");
+        delete image;
         return NULL;
     }
-    SDL_Surface *surface;
-    GLenum texture_format;
-    GLint  nOfColors;
-    GLuint texture;
+    image->setWidth(width);
+    image->setHeight(height);
+    return image;
+}
 
-    if ( (surface = IMG_Load(filename.c_str())) ) {
+void RosalilaGraphics::setRenderTarget(Image* target)
+{
+    //While post processing the frame goes to the scene instead of the screen
+    if(!target && post_process.scene_active)
+        target = post_process.scene;
+    switchRenderTarget(target);
+}
 
-            // get the number of channels in the SDL surface
-            nOfColors = surface->format->BytesPerPixel;
-            if (nOfColors == 4)     // contains an alpha channel
-            {
-                    if (surface->format->Rmask == 0x000000ff)
-                            texture_format = GL_RGBA;
-                    //else
-                            //texture_format = GL_BGRA;
-            } else if (nOfColors == 3)     // no alpha channel
-            {
-                    if (surface->format->Rmask == 0x000000ff)
-                            texture_format = GL_RGB;
-                    //else
-                            //texture_format = GL_BGR;
-            } else {
-                rosalila()->utility->writeLogLine("Warning: "+ filename+ " is not truecolor. This will probably break.");
-                    // this error should not go unhandled
-            }
+void RosalilaGraphics::switchRenderTarget(Image* target)
+{
+    if(target == render_target)
+        return;
 
-        // Have OpenGL generate a texture object handle for us
-        glGenTextures( 1, &texture );
+    //Everything batched so far goes to the last target
+    sprite_batch.flush();
+    render_target = target;
+
+    GLuint framebuffer = target ? target->framebuffer : 0;
+    int width = target ? target->original_width : screen_width;
+    int height = target ? target->original_height : screen_height;
+    //The scene reads like the screen, screenshots of it come out the same
+    bool bottom_up = target && target != post_process.scene;
+    if(render_thread.running)
+        render_thread.recordRenderTarget(framebuffer, width, height, bottom_up);
+    else
+        bindRenderTarget(framebuffer, width, height, bottom_up);
+}
 
-        // Bind the texture object
-        glBindTexture( GL_TEXTURE_2D, texture );
+void RosalilaGraphics::bindRenderTarget(GLuint framebuffer, int width, int height, bool bottom_up)
+{
+    state_cache.bindFramebuffer(framebuffer);
+    if(framebuffer)
+        glViewport(0, 0, width, height);
+    else
+        glViewport(0, 0, screen_resized_width, screen_resized_height);
+    target_framebuffer = framebuffer;
+    target_width = width;
+    target_height = height;
+    target_bottom_up = bottom_up;
+}
 
-        // Set the texture's stretching properties
-            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+int RosalilaGraphics::addPostProcessPass(std::string fragment_source)
+{
+    int pass = post_process.addPass(fragment_source);
+    if(pass == -1)
+        rosalila()->utility->writeLogLine("Warning: Could not add the post process pass.");
+    return pass;
+}
 
-//for(int x=0;x<surface->w;x++)
-//for(int y=0;y<surface->h;y++)
-//((unsigned int*)surface->pixels)[y*(surface->pitch/sizeof(unsigned int)) + x]+=1;
-        // Edit the texture object's image data using the information SDL_Surface gives us
-#ifdef OSX
-        glTexImage2D( GL_TEXTURE_2D, 0, nOfColors, surface->w, surface->h, 0,
-                          GL_BGRA, GL_UNSIGNED_BYTE, surface->pixels );
-#else
-        glTexImage2D( GL_TEXTURE_2D, 0, nOfColors, surface->w, surface->h, 0,
-                          texture_format, GL_UNSIGNED_BYTE, surface->pixels );
-#endif
+Color RosalilaGraphics::applyColorEffects(Color color)
+{
+    double grey_scale = (color.red+color.green+color.blue)/3;
+
+    double red_difference = color.red-grey_scale;
+    double green_difference = color.green-grey_scale;
+    double blue_difference = color.blue-grey_scale;
+
+    color.red = (int)(grey_scale + red_difference * draw_saturation);
+    color.green = (int)(grey_scale + green_difference * draw_saturation);
+    color.blue = (int)(grey_scale + blue_difference * draw_saturation);
+
+    color.alpha = (int)(color.alpha * draw_fade);
+    return color;
+}
+
+Image* RosalilaGraphics::getImage(std::string filename)
+{
+    return getImage(filename, texture_atlas_enabled);
+}
+
+Image* RosalilaGraphics::getImage(std::string filename, bool use_texture_atlas)
+{
+    ROSALILA_TRACE("RosalilaGraphics::getImage");
+    if(!rosalila()->utility->fileExists(filename))
+    {
+        rosalila()->utility->writeLogLine("Warning: "+ filename+ " does not exist. Image could not be loaded.");        
+        return NULL;
     }
-    else {
+    SDL_Surface *surface;
+
+    if ( !(surface = IMG_Load(filename.c_str())) ) {
         std::string sdl_error=SDL_GetError();
         rosalila()->utility->writeLogLine("SDL could not load "+filename+": "+sdl_error);
         SDL_Quit();
         return NULL;
     }
 
-
     Image*image=new Image();
-    image->setTexture(texture);
-    image->setWidth(surface->w);
-    image->setHeight(surface->h);
+    uploadImage(image, surface, use_texture_atlas, filename);
 
     // Free the SDL_Surface only if it was successfully created
     if ( surface ) {
         SDL_FreeSurface( surface );
     }
 
-    rosalila()->utility->writeLogLine(filename+" loaded");
-
     return image;
 }
 
-void RosalilaGraphics::drawImage (Image* texture, int x, int y)
+Image* RosalilaGraphics::getImageAsync(std::string filename, std::function<void(Image*)> callback)
 {
-    double grey_scale = (texture->color_filter.red+texture->color_filter.green+texture->color_filter.blue)/3;
+    return image_loader.load(filename, texture_atlas_enabled, callback);
+}
 
-    double red_difference = texture->color_filter.red-grey_scale;
-    double green_difference = texture->color_filter.green-grey_scale;
-    double blue_difference = texture->color_filter.blue-grey_scale;
+void RosalilaGraphics::uploadImage(Image* image, SDL_Surface* surface, bool use_texture_atlas, std::string filename)
+{
+    ROSALILA_TRACE("RosalilaGraphics::uploadImage");
+    GLenum texture_format;
+    GLint  nOfColors;
+    GLuint texture;
 
-    texture->color_filter.red = (int)(grey_scale + red_difference * grayscale_effect.current_percentage);
-	texture->color_filter.green = (int)(grey_scale + green_difference * grayscale_effect.current_percentage);
-    texture->color_filter.blue = (int)(grey_scale + blue_difference * grayscale_effect.current_percentage);
+    // get the number of channels in the SDL surface
+    nOfColors = surface->format->BytesPerPixel;
+    if (nOfColors == 4)     // contains an alpha channel
+    {
+            if (surface->format->Rmask == 0x000000ff)
+                    texture_format = GL_RGBA;
+            //else
+                    //texture_format = GL_BGRA;
+    } else if (nOfColors == 3)     // no alpha channel
+    {
+            if (surface->format->Rmask == 0x000000ff)
+                    texture_format = GL_RGB;
+            //else
+                    //texture_format = GL_BGR;
+    } else {
+        rosalila()->utility->writeLogLine("Warning: "+ filename+ " is not truecolor. This will probably break.");
+            // this error should not go unhandled
+    }
 
-    texture->color_filter.alpha = (int)(texture->color_filter.alpha * transparency_effect.current_percentage);
+    if(use_texture_atlas
+       && surface->w <= texture_atlas_max_image_size
+       && surface->h <= texture_atlas_max_image_size)
+    {
+#ifdef OSX
+        bool added = addToTextureAtlas(surface, GL_BGRA, image);
+#else
+        bool added = addToTextureAtlas(surface, texture_format, image);
+#endif
+        if(added)
+        {
+            rosalila()->utility->writeLogLine(filename+" loaded on texture atlas");
+            return;
+        }
+    }
 
-    glEnable( GL_TEXTURE_2D );
+//for(int x=0;x<surface->w;x++)
+//for(int y=0;y<surface->h;y++)
+//((unsigned int*)surface->pixels)[y*(surface->pitch/sizeof(unsigned int)) + x]+=1;
+    runOnRenderThread([&]()
+    {
+        // Create the texture with linear stretching from the information SDL_Surface gives us
+#ifdef OSX
+        texture = texture_uploader.createTexture( surface->w, surface->h, nOfColors == 4 ? GL_RGBA : GL_RGB,
+                                                  GL_BGRA, surface->pixels, surface->pitch, GL_LINEAR );
+#else
+        texture = texture_uploader.createTexture( surface->w, surface->h, nOfColors == 4 ? GL_RGBA : GL_RGB,
+                                                  texture_format, surface->pixels, surface->pitch, GL_LINEAR );
+#endif
+    });
 
-    glMatrixMode( GL_PROJECTION );
-    glLoadIdentity();
-    glOrtho(0.0f, screen_width, screen_height, 0.0f, -1.0f, 1.0f);
-    glMatrixMode( GL_MODELVIEW );
+    image->setTexture(texture);
+    image->setWidth(surface->w);
+    image->setHeight(surface->h);
 
-    glDisable (GL_LIGHTING);
-    glEnable (GL_LIGHT0);
-    glDisable (GL_DEPTH_TEST);
+    rosalila()->utility->writeLogLine(filename+" loaded");
+}
 
-    //Screen shake
-    x += screen_shake_effect.current_x;
-    y += screen_shake_effect.current_y;
+Image* RosalilaGraphics::addToTextureAtlas(SDL_Surface* surface, GLenum texture_format)
+{
+    Image* image = new Image();
+    if(addToTextureAtlas(surface, texture_format, image))
+        return image;
+    delete image;
+    return NULL;
+}
 
-    GLfloat x1 = 0.f + x;
-    GLfloat y1 = 0.f + y;
-    GLfloat x2 = 0.f + x + (float)texture->width * texture->scale;
-    GLfloat y2 = 0.f + y + (float)texture->height * texture->scale;
+bool RosalilaGraphics::addToTextureAtlas(SDL_Surface* surface, GLenum texture_format, Image* image)
+{
+    //One pixel border around the image so linear filtering never samples the neighbours
+    int padded_width = surface->w + 2;
+    int padded_height = surface->h + 2;
+    if(padded_width > texture_atlas_size || padded_height > texture_atlas_size)
+        return false;
+
+    int x = 0;
+    int y = 0;
+    TextureAtlas* atlas = NULL;
+    for(int i=0;i<(int)texture_atlases.size();i++)
+    {
+        if(texture_atlases[i]->insert(padded_width, padded_height, x, y))
+        {
+            atlas = texture_atlases[i];
+            break;
+        }
+    }
 
-    //Flip
-    if(texture->horizontal_flip)
+    if(!atlas)
     {
-        GLfloat temp=x1;
-        x1=x2;
-        x2=temp;
+        runOnRenderThread([&]()
+        {
+            atlas = new TextureAtlas(texture_atlas_size, texture_atlas_size);
+        });
+        texture_atlases.push_back(atlas);
+        rosalila()->utility->writeLogLine("Texture atlas page "+rosalila()->utility->toString((int)texture_atlases.size())+" created");
+        if(!atlas->insert(padded_width, padded_height, x, y))
+            return false;
     }
 
-    //OpenGL draw
-    //Save the current matrix.
-    glPushMatrix();
-    //Change the current matrix.
-    float translate_x = (x2-x1) / 2 + x;
-    float translate_y = (y2-y1) /2 + y;
-    glTranslatef(translate_x,translate_y, 1.0);
-    glRotatef(-texture->rotation, 0, 0, 1.0);
-
-    glColor4ub(texture->color_filter.red, texture->color_filter.green, texture->color_filter.blue,texture->color_filter.alpha);
-    glEnable(GL_BLEND);
-    //glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-    //glBlendFunc(GL_SRC_ALPHA, GL_ONE); // additive
-    // GL_ONE_MINUS_SRC_COLOR - funky
-    // GL_SRC_ALPHA - wuut
-    // GL_ONE_MINUS_SRC_ALPHA - standard
-    // GL_ONE - additive
-    // glBlendFunc(GL_ZERO, GL_SRC_ALPHA);
-    //glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE);
-    //glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-    //glBlendFuncSeparate(GL_SRC_COLOR, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
-    
-    /*
-    if(texture->blend_effect)
-        glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_COLOR, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        //glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_COLOR, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-    else
-        glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-    */
-    glBindTexture( GL_TEXTURE_2D, texture->getTexture() );
+    //The border repeats the image edges
+    int bytes_per_pixel = surface->format->BytesPerPixel;
+    int source_row_size = surface->w * bytes_per_pixel;
+    int padded_row_size = padded_width * bytes_per_pixel;
+    vector<GLubyte> pixels(padded_row_size * padded_height);
+    for(int row=0;row<padded_height;row++)
+    {
+        int source_row_index = row - 1;
+        if(source_row_index < 0)
+            source_row_index = 0;
+        if(source_row_index >= surface->h)
+            source_row_index = surface->h - 1;
+
+        GLubyte* source_row = (GLubyte*)surface->pixels + source_row_index * surface->pitch;
+        GLubyte* padded_row = &pixels[row * padded_row_size];
+        memcpy(padded_row + bytes_per_pixel, source_row, source_row_size);
+        memcpy(padded_row, source_row, bytes_per_pixel);
+        memcpy(padded_row + padded_row_size - bytes_per_pixel, source_row + source_row_size - bytes_per_pixel, bytes_per_pixel);
+    }
 
+    runOnRenderThread([&]()
+    {
+        texture_uploader.updateTexture( atlas->texture, x, y, padded_width, padded_height,
+                                        texture_format, &pixels[0], padded_row_size );
+    });
 
-    glBegin( GL_QUADS);
-        //Bottom-left vertex (corner)
-        glTexCoord2i( 0, 0 );
-        glVertex3f( x1-translate_x, y1-translate_y, 0.0f );
+    image->setTexture(atlas->texture);
+    image->setWidth(surface->w);
+    image->setHeight(surface->h);
+    image->texture_atlas = atlas;
+    image->uv_x1 = (GLfloat)(x + 1) / atlas->width;
+    image->uv_y1 = (GLfloat)(y + 1) / atlas->height;
+    image->uv_x2 = (GLfloat)(x + 1 + surface->w) / atlas->width;
+    image->uv_y2 = (GLfloat)(y + 1 + surface->h) / atlas->height;
+    return true;
+}
 
-        //Bottom-right vertex (corner)
-        glTexCoord2i( 1, 0 );
-        glVertex3f( x2-translate_x, y1-translate_y, 0.f );
+void RosalilaGraphics::drawImage (Image* texture, int x, int y)
+{
+    //Still loading on getImageAsync
+    if(!texture->ready)
+        return;
 
-        //Top-right vertex (corner)
-        glTexCoord2i( 1, 1 );
-        glVertex3f( x2-translate_x, y2-translate_y, 0.f );
+    //Render targets hold premultiplied colors
+    GLenum blend_source = GL_SRC_ALPHA;
+    Color color = texture->color_filter;
+    if(draw_saturation != 1.0 || draw_fade != 1.0)
+        color = applyColorEffects(color);
+    if(texture->framebuffer)
+    {
+        blend_source = GL_ONE;
+        color.red = color.red * color.alpha / 255;
+        color.green = color.green * color.alpha / 255;
+        color.blue = color.blue * color.alpha / 255;
+    }
 
-        //Top-left vertex (corner)
-        glTexCoord2i( 0, 1 );
-        glVertex3f( x1-translate_x, y2-translate_y, 0.f );
+    //Screen shake
+    x += draw_offset_x;
+    y += draw_offset_y;
 
-    glEnd();
+    GLfloat x1 = 0.f + x;
+    GLfloat y1 = 0.f + y;
+    GLfloat x2 = 0.f + x + (float)texture->width * texture->scale;
+    GLfloat y2 = 0.f + y + (float)texture->height * texture->scale;
 
-    //Reset the current matrix to the one that was saved.
-    glPopMatrix();
+    //Rotate around the image center
+    float translate_x = (x2-x1) / 2 + x;
+    float translate_y = (y2-y1) /2 + y;
+    if(texture->horizontal_flip)
+        translate_x = (x1-x2) / 2 + x;
+
+    //The flip is done by the batch
+    sprite_batch.draw(texture->getTexture(), blend_source, GL_ONE_MINUS_SRC_ALPHA,
+                      translate_x, translate_y, texture->rotation, texture->horizontal_flip,
+                      x1-translate_x, y1-translate_y, x2-translate_x, y2-translate_y,
+                      texture->uv_x1, texture->uv_y1, texture->uv_x2, texture->uv_y2,
+                      color);
 }
 
 void RosalilaGraphics::drawCroppedImage (Image* texture, int x, int y, int crop_x, int crop_y, int crop_width, int crop_height)
 {
-    double grey_scale = (texture->color_filter.red+texture->color_filter.green+texture->color_filter.blue)/3;
-
-    double red_difference = texture->color_filter.red-grey_scale;
-    double green_difference = texture->color_filter.green-grey_scale;
-    double blue_difference = texture->color_filter.blue-grey_scale;
-
-    texture->color_filter.red = (int)(grey_scale + red_difference * grayscale_effect.current_percentage);
-    texture->color_filter.green = (int)(grey_scale + green_difference * grayscale_effect.current_percentage);
-    texture->color_filter.blue = (int)(grey_scale + blue_difference * grayscale_effect.current_percentage);
-
-    texture->color_filter.alpha = (int)(texture->color_filter.alpha * transparency_effect.current_percentage);
-
-    glEnable( GL_TEXTURE_2D );
-
-    glMatrixMode( GL_PROJECTION );
-    glLoadIdentity();
-    glOrtho(0.0f, screen_width, screen_height, 0.0f, -1.0f, 1.0f);
-    glMatrixMode( GL_MODELVIEW );
+    if(!texture->ready)
+        return;
 
-    glDisable (GL_LIGHTING);
-    glEnable (GL_LIGHT0);
-    glDisable (GL_DEPTH_TEST);
+    //Render targets hold premultiplied colors
+    GLenum blend_source = GL_SRC_ALPHA;
+    Color color = texture->color_filter;
+    if(draw_saturation != 1.0 || draw_fade != 1.0)
+        color = applyColorEffects(color);
+    if(texture->framebuffer)
+    {
+        blend_source = GL_ONE;
+        color.red = color.red * color.alpha / 255;
+        color.green = color.green * color.alpha / 255;
+        color.blue = color.blue * color.alpha / 255;
+    }
 
     //Screen shake
-    x += screen_shake_effect.current_x;
-    y += screen_shake_effect.current_y;
+    x += draw_offset_x;
+    y += draw_offset_y;
 
     
     double x_crop_percent = double(crop_x) / texture->width;
@@ -639,289 +1062,147 @@ void RosalilaGraphics::drawCroppedImage (Image* texture, int x, int y, int crop_
     y1 *= (GLfloat)height_crop_percent;
     y2 *= (GLfloat)height_crop_percent;
 
-    //Flip
-    if(texture->horizontal_flip)
-    {
-        GLfloat temp=x1;
-        x1=x2;
-        x2=temp;
-    }
-
-    //OpenGL draw
-    //Save the current matrix.
-    glPushMatrix();
-    //Change the current matrix.
     float translate_x = (x2-x1) / 2 + x;
     float translate_y = (y2-y1) /2 + y;
-    glTranslatef(translate_x,translate_y, 1.0);
-    glRotatef(-texture->rotation, 0, 0, 1.0);
-
-    glColor4ub(texture->color_filter.red, texture->color_filter.green, texture->color_filter.blue,texture->color_filter.alpha);
-    glEnable(GL_BLEND);
-    //glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-    //glBlendFunc(GL_SRC_ALPHA, GL_ONE); // additive
-    // GL_ONE_MINUS_SRC_COLOR - funky
-    // GL_SRC_ALPHA - wuut
-    // GL_ONE_MINUS_SRC_ALPHA - standard
-    // GL_ONE - additive
-    // glBlendFunc(GL_ZERO, GL_SRC_ALPHA);
-    //glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE);
-    //glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-    //glBlendFuncSeparate(GL_SRC_COLOR, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
-    
-    /*
-    if(texture->blend_effect)
-        glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_COLOR, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        //glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_COLOR, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-    else
-        glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-    */
-    glBindTexture( GL_TEXTURE_2D, texture->getTexture() );
-
-
-    glBegin( GL_QUADS);
-        //Bottom-left vertex (corner)
-        glTexCoord2f((GLfloat)x_crop_percent, (GLfloat)y_crop_percent);
-        glVertex3d(x1, y1, 0.0f);
-
-        //Bottom-right vertex (corner)
-        glTexCoord2f((GLfloat)(width_crop_percenent + x_crop_percent), (GLfloat)y_crop_percent);
-        glVertex3d(x2, y1, 0.f);
-
-        //Top-right vertex (corner)
-        glTexCoord2f((GLfloat)(width_crop_percenent + x_crop_percent), (GLfloat)(height_crop_percent + y_crop_percent));
-        glVertex3d(x2, y2, 0.f);
-
-        //Top-left vertex (corner)
-        glTexCoord2f((GLfloat)x_crop_percent, (GLfloat)(height_crop_percent + y_crop_percent));
-        glVertex3d(x1, y2, 0.f);
-    glEnd();
-
-    //Reset the current matrix to the one that was saved.
-    glPopMatrix();
+    if(texture->horizontal_flip)
+        translate_x = (x1-x2) / 2 + x;
+
+    //Crop inside the image area of the texture
+    GLfloat uv_width = texture->uv_x2 - texture->uv_x1;
+    GLfloat uv_height = texture->uv_y2 - texture->uv_y1;
+
+    sprite_batch.draw(texture->getTexture(), blend_source, GL_ONE_MINUS_SRC_ALPHA,
+                      translate_x, translate_y, texture->rotation, texture->horizontal_flip,
+                      x1, y1, x2, y2,
+                      texture->uv_x1 + (GLfloat)x_crop_percent * uv_width,
+                      texture->uv_y1 + (GLfloat)y_crop_percent * uv_height,
+                      texture->uv_x1 + (GLfloat)(width_crop_percenent + x_crop_percent) * uv_width,
+                      texture->uv_y1 + (GLfloat)(height_crop_percent + y_crop_percent) * uv_height,
+                      color);
 }
 
 void RosalilaGraphics::draw2DImageBatch(
              Image* texture,
              int size_x,int size_y,
-             vector<int> position_x,vector<int>position_y,
+             const vector<int>& position_x,const vector<int>& position_y,
              float scale,
-             vector<float>rotation,
+             const vector<float>& rotation,
              bool flipHorizontally,
              Color color_effects)
 {
-    glEnable( GL_TEXTURE_2D );
-
-    glMatrixMode( GL_PROJECTION );
-    glLoadIdentity();
-    glOrtho(0.0f, screen_width, screen_height, 0.0f, -1.0f, 1.0f);
-    glMatrixMode( GL_MODELVIEW );
-
-    glDisable (GL_LIGHTING);
-    glEnable (GL_LIGHT0);
-    glDisable (GL_DEPTH_TEST);
-
-    glColor4ub(color_effects.red, color_effects.green, color_effects.blue,color_effects.alpha);
-    glEnable(GL_BLEND);
-    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-
-    glBindTexture( GL_TEXTURE_2D, texture->getTexture() );
-
-
+    if(!texture->ready)
+        return;
 
-    glPushMatrix();
-    glTranslatef(1.0,1.0, 1.0);
+    float half_width = (float)size_x*scale / 2;
+    float half_height = (float)size_y*scale / 2;
 
-    glBegin( GL_QUADS);
     for(int i=0;i<(int)position_x.size();i++)
     {
         //Screen shake
-        position_x[i] += screen_shake_effect.current_x;
-        position_y[i] += screen_shake_effect.current_y;
+        float center_x = position_x[i] + draw_offset_x + half_width;
+        float center_y = position_y[i] + draw_offset_y + half_height;
+
+        //Each image rotates around its center
+        float image_rotation = 0;
+        if(i < (int)rotation.size())
+            image_rotation = rotation[i];
+
+        sprite_batch.draw(texture->getTexture(), GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+                          center_x, center_y, image_rotation, flipHorizontally,
+                          -half_width, -half_height, half_width, half_height,
+                          texture->uv_x1, texture->uv_y1, texture->uv_x2, texture->uv_y2,
+                          color_effects);
+    }
+}
 
-        GLfloat x1=0.f+position_x[i];
-        GLfloat y1=0.f+position_y[i];
-        GLfloat x2=0.f+position_x[i]+(float)size_x*scale;
-        GLfloat y2=0.f+position_y[i]+(float)size_y*scale;
+void RosalilaGraphics::drawImageInstances(Image* texture, const SpriteInstance* instances, int count)
+{
+    if(!texture->ready || count <= 0)
+        return;
 
-        //Flip
-        if(flipHorizontally)
+    //Same colors as drawImage, the instances of the caller are left as they are
+    GLenum blend_source = GL_SRC_ALPHA;
+    bool effects = draw_saturation != 1.0 || draw_fade != 1.0;
+    if(texture->framebuffer)
+        blend_source = GL_ONE;
+    if(effects || texture->framebuffer)
+    {
+        effect_instances.assign(instances, instances + count);
+        for(int i=0;i<count;i++)
         {
-            GLfloat temp=x1;
-            x1=x2;
-            x2=temp;
+            SpriteInstance& instance = effect_instances[i];
+            Color color(instance.red, instance.green, instance.blue, instance.alpha);
+            if(effects)
+                color = applyColorEffects(color);
+            //Render targets hold premultiplied colors
+            if(texture->framebuffer)
+            {
+                color.red = color.red * color.alpha / 255;
+                color.green = color.green * color.alpha / 255;
+                color.blue = color.blue * color.alpha / 255;
+            }
+            instance.red = (GLubyte)color.red;
+            instance.green = (GLubyte)color.green;
+            instance.blue = (GLubyte)color.blue;
+            instance.alpha = (GLubyte)color.alpha;
         }
-
-        //OpenGL draw
-        //Save the current matrix.
-
-        //Change the current matrix.
-        //glTranslatef(translate_x,translate_y, 1.0);
-
-        //glRotatef(-rotation[i], 0, 0, 1.0);
-
-
-            //Bottom-left vertex (corner)
-            glTexCoord2i( 0, 0 );
-            glVertex3f( x1, y1, 0.0f );
-
-            //Bottom-right vertex (corner)
-            glTexCoord2i( 1, 0 );
-            glVertex3f( x2, y1, 0.f );
-
-            //Top-right vertex (corner)
-            glTexCoord2i( 1, 1 );
-            glVertex3f( x2, y2, 0.f );
-
-            //Top-left vertex (corner)
-            glTexCoord2i( 0, 1 );
-            glVertex3f( x1, y2, 0.f );
-
-
-
+        instances = &effect_instances[0];
     }
-    glEnd();
-    glPopMatrix();
 
-    //Reset the current matrix to the one that was saved.
-//    glPopMatrix();
+    sprite_batch.drawInstances(texture->getTexture(), blend_source, (float)texture->width, (float)texture->height,
+                               texture->uv_x1, texture->uv_y1, texture->uv_x2, texture->uv_y2,
+                               texture->horizontal_flip,
+                               (float)draw_offset_x, (float)draw_offset_y,
+                               instances, count);
 }
 
 
 void RosalilaGraphics::drawRectangle(int x,int y,int width,int height,float rotation,int red,int green,int blue,int alpha)
 {
-    glMatrixMode( GL_PROJECTION );
-    glLoadIdentity();
-    glOrtho(0.0f, screen_width, screen_height, 0.0f, -1.0f, 1.0f);
-    glMatrixMode( GL_MODELVIEW );
-
-    glDisable (GL_LIGHTING);
-    glEnable (GL_LIGHT0);
-    glDisable (GL_DEPTH_TEST);
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    glDisable(GL_TEXTURE_2D);
-    GLubyte r=red;
-    GLubyte g=green;
-    GLubyte b=blue;
-    GLubyte a=alpha;
-    glColor4ub(r,g,b,a);
-
-    //OpenGL draw
-    //Save the current matrix.
-    glPushMatrix();
-    //Change the current matrix.
-	GLfloat translate_x = (GLfloat)x;
-	GLfloat translate_y = (GLfloat)y;
-    glTranslatef(translate_x,translate_y, 1.0);
-    glRotatef(-rotation, 0, 0, 1.0);
-    x -= (int)translate_x;
-    y -= (int)translate_y;
-
-//    glRecti(x, y, width+x, height+y);
-
-
-
-    glBegin(GL_QUADS);   //We want to draw a quad, i.e. shape with four sides
-      glColor4ub(red,green,blue,alpha);
-      glVertex2f(0, 0);
-      glVertex2f(0, (GLfloat)height);
-      glVertex2f((GLfloat)width, (GLfloat)height);
-      glVertex2f((GLfloat)width, 0);
-    glEnd();
-
-    glFlush();
-
-    //Reset the current matrix to the one that was saved.
-    glPopMatrix();
+    //Rotated around the top left corner
+    sprite_batch.draw(sprite_batch.white_texture, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+                      (float)x, (float)y, rotation, false,
+                      0, 0, (float)width, (float)height,
+                      0.5f, 0.5f, 0.5f, 0.5f,
+                      Color(red, green, blue, alpha));
 }
 
 void RosalilaGraphics::drawRectangles(vector<DrawableRectangle*>rectangles)
 {
-    glLoadIdentity();
-    glMatrixMode( GL_MODELVIEW );
-
-    glPushMatrix();
-
-    glDisable (GL_LIGHTING);
-    glEnable (GL_LIGHT0);
-    glDisable (GL_DEPTH_TEST);
-
-    glDisable(GL_TEXTURE_2D);
-
-    glTranslatef(0,0, 1.0);
-
-    glBegin(GL_QUADS);
-
     for(int i=0;i<(int)rectangles.size();i++)
     {
-        double grey_scale = (rectangles[i]->color.red+rectangles[i]->color.green+rectangles[i]->color.blue)/3;
-
-        double red_difference = rectangles[i]->color.red-grey_scale;
-        double green_difference = rectangles[i]->color.green-grey_scale;
-        double blue_difference = rectangles[i]->color.blue-grey_scale;
-
-        rectangles[i]->color.red = (int)(grey_scale + red_difference * grayscale_effect.current_percentage);
-        rectangles[i]->color.green = (int)(grey_scale + green_difference * grayscale_effect.current_percentage);
-        rectangles[i]->color.blue = (int)(grey_scale + blue_difference * grayscale_effect.current_percentage);
+        Color color = rectangles[i]->color;
+        if(draw_saturation != 1.0 || draw_fade != 1.0)
+            color = applyColorEffects(color);
 
-        rectangles[i]->color.alpha = (int)(rectangles[i]->color.alpha * transparency_effect.current_percentage);
+        int x = rectangles[i]->x + draw_offset_x;
+        int y = rectangles[i]->y + draw_offset_y;
 
-        rectangles[i]->x += screen_shake_effect.current_x;
-        rectangles[i]->y += screen_shake_effect.current_y;
+        Point p1(x,
+                 y);
+        Point p2(x,
+                  y+rectangles[i]->height);
+        Point p3(x+rectangles[i]->width,
+                  y+rectangles[i]->height);
+        Point p4(x+rectangles[i]->width,
+                  y);
 
-        Point p1(rectangles[i]->x,
-                 rectangles[i]->y);
-        Point p2(rectangles[i]->x,
-                  rectangles[i]->y+rectangles[i]->height);
-        Point p3(rectangles[i]->x+rectangles[i]->width,
-                  rectangles[i]->y+rectangles[i]->height);
-        Point p4(rectangles[i]->x+rectangles[i]->width,
-                  rectangles[i]->y);
-
-        Point center(rectangles[i]->x+rectangles[i]->width/2,
-                     rectangles[i]->y+rectangles[i]->height/2);
+        Point center(x+rectangles[i]->width/2,
+                     y+rectangles[i]->height/2);
 
         p1 = rosalila()->utility->realRotateAroundPoint(p1,center, (float)rectangles[i]->angle);
         p2 = rosalila()->utility->realRotateAroundPoint(p2,center, (float)rectangles[i]->angle);
         p3 = rosalila()->utility->realRotateAroundPoint(p3,center, (float)rectangles[i]->angle);
         p4 = rosalila()->utility->realRotateAroundPoint(p4,center, (float)rectangles[i]->angle);
 
-        glColor4ub(rectangles[i]->color.red,rectangles[i]->color.green,rectangles[i]->color.blue,rectangles[i]->color.alpha);
-
-        glVertex2f((GLfloat)p1.x, (GLfloat)p1.y);
-        glVertex2f((GLfloat)p2.x, (GLfloat)p2.y);
-        glVertex2f((GLfloat)p3.x, (GLfloat)p3.y);
-        glVertex2f((GLfloat)p4.x, (GLfloat)p4.y);
+        float points_x[4] = {(float)p1.x, (float)p2.x, (float)p3.x, (float)p4.x};
+        float points_y[4] = {(float)p1.y, (float)p2.y, (float)p3.y, (float)p4.y};
+        sprite_batch.drawShape(points_x, points_y, 4, color);
     }
-
-    glEnd();
-    glFlush();
-    glPopMatrix();
 }
 
 void RosalilaGraphics::drawPoints(list<DrawablePoint*>points)
 {
-    glLoadIdentity();
-    glMatrixMode( GL_MODELVIEW );
-
-    glPushMatrix();
-
-    glDisable (GL_LIGHTING);
-    glEnable (GL_LIGHT0);
-    glDisable (GL_DEPTH_TEST);
-
-    glDisable(GL_TEXTURE_2D);
-
-    glTranslatef(0,0, 1.0);
-
-
-    glPointSize(5);
-    glBegin(GL_POINTS);
-
-
     for(list<DrawablePoint*>::iterator i=points.begin();
         i!=points.end();
         i++)
@@ -929,246 +1210,164 @@ void RosalilaGraphics::drawPoints(list<DrawablePoint*>points)
         int x = (*i)->point.x;
         int y = (*i)->point.y;
 
-        glColor4ub((*i)->color.red,(*i)->color.green,(*i)->color.blue,(*i)->color.alpha);
-        glVertex3f((GLfloat)x, (GLfloat)y, 0.0f);
+        //Same area a 5 pixels glPointSize covered
+        sprite_batch.draw(sprite_batch.white_texture, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+                          (float)x, (float)y, 0, false,
+                          -2.5f, -2.5f, 2.5f, 2.5f,
+                          0.5f, 0.5f, 0.5f, 0.5f,
+                          (*i)->color);
     }
-
-    glEnd( );
-    glFlush();
-    glPopMatrix();
 }
 
 void RosalilaGraphics::drawTriangles(vector<DrawableTriangle*>triangles)
 {
-    glLoadIdentity();
-    glMatrixMode( GL_MODELVIEW );
-
-    glPushMatrix();
-
-    glDisable (GL_LIGHTING);
-    glEnable (GL_LIGHT0);
-    glDisable (GL_DEPTH_TEST);
-
-    glDisable(GL_TEXTURE_2D);
-
-    glTranslatef(0,0, 1.0);
-
-    glBegin(GL_TRIANGLES);
-
     for(int i=0;i<(int)triangles.size();i++)
     {
-        double grey_scale = (triangles[i]->color.red+triangles[i]->color.green+triangles[i]->color.blue)/3;
-
-        double red_difference = triangles[i]->color.red-grey_scale;
-        double green_difference = triangles[i]->color.green-grey_scale;
-        double blue_difference = triangles[i]->color.blue-grey_scale;
-
-        triangles[i]->color.red = (int)(grey_scale + red_difference * grayscale_effect.current_percentage);
-        triangles[i]->color.green = (int)(grey_scale + green_difference * grayscale_effect.current_percentage);
-        triangles[i]->color.blue = (int)(grey_scale + blue_difference * grayscale_effect.current_percentage);
-
-        triangles[i]->color.alpha = (int)(triangles[i]->color.alpha * transparency_effect.current_percentage);
-
-        triangles[i]->x += screen_shake_effect.current_x;
-        triangles[i]->y += screen_shake_effect.current_y;
-
-        triangles[i]->p1.x += triangles[i]->x;
-        triangles[i]->p1.y += triangles[i]->y;
-        triangles[i]->p2.x += triangles[i]->x;
-        triangles[i]->p2.y += triangles[i]->y;
-        triangles[i]->p3.x += triangles[i]->x;
-        triangles[i]->p3.y += triangles[i]->y;
-
-        Point center(triangles[i]->x,triangles[i]->y);//This should not be the center
-
-        triangles[i]->p1 = rosalila()->utility->realRotateAroundPoint(triangles[i]->p1,center, (GLfloat)triangles[i]->angle);
-        triangles[i]->p2 = rosalila()->utility->realRotateAroundPoint(triangles[i]->p2,center, (GLfloat)triangles[i]->angle);
-        triangles[i]->p3 = rosalila()->utility->realRotateAroundPoint(triangles[i]->p3,center, (GLfloat)triangles[i]->angle);
-
-        glColor4ub(triangles[i]->color.red,triangles[i]->color.green,triangles[i]->color.blue,triangles[i]->color.alpha);
-
-        glVertex2f((GLfloat)triangles[i]->p1.x, (GLfloat)triangles[i]->p1.y);
-        glVertex2f((GLfloat)triangles[i]->p2.x, (GLfloat)triangles[i]->p2.y);
-        glVertex2f((GLfloat)triangles[i]->p3.x, (GLfloat)triangles[i]->p3.y);
+        Color color = triangles[i]->color;
+        if(draw_saturation != 1.0 || draw_fade != 1.0)
+            color = applyColorEffects(color);
+
+        int x = triangles[i]->x + draw_offset_x;
+        int y = triangles[i]->y + draw_offset_y;
+
+        Point p1 = triangles[i]->p1;
+        Point p2 = triangles[i]->p2;
+        Point p3 = triangles[i]->p3;
+        p1.x += x;
+        p1.y += y;
+        p2.x += x;
+        p2.y += y;
+        p3.x += x;
+        p3.y += y;
+
+        Point center(x,y);//This should not be the center
+
+        p1 = rosalila()->utility->realRotateAroundPoint(p1,center, (GLfloat)triangles[i]->angle);
+        p2 = rosalila()->utility->realRotateAroundPoint(p2,center, (GLfloat)triangles[i]->angle);
+        p3 = rosalila()->utility->realRotateAroundPoint(p3,center, (GLfloat)triangles[i]->angle);
+
+        float points_x[3] = {(float)p1.x, (float)p2.x, (float)p3.x};
+        float points_y[3] = {(float)p1.y, (float)p2.y, (float)p3.y};
+        sprite_batch.drawShape(points_x, points_y, 3, color);
     }
-
-    glEnd();
-    glFlush();
-    glPopMatrix();
 }
 
 void RosalilaGraphics::frameCap()
 {
+    ROSALILA_TRACE("RosalilaGraphics::frameCap");
     frame++;
 
-    //If a second has passed since the caption was last updated
-
     //If we want to cap the frame rate
-    int ticks_difference = SDL_GetTicks() - last_tick;
-    if(ticks_difference < 1000 / frames_per_seccond)
-    {
-        //Sleep the remaining frame time
-        SDL_Delay( ( 1000 / frames_per_seccond ) - ticks_difference );
-    }
+    frame_pacer.wait(frames_per_seccond);
 
     last_tick = SDL_GetTicks();
 }
-void RosalilaGraphics::drawText(std::string text,int position_x,int position_y, bool center_x, bool center_y)
+void RosalilaGraphics::drawFrameStats()
 {
-  position_x += screen_shake_effect.current_x;
-  position_y += screen_shake_effect.current_y;
-
-  if(text=="")
-      text=" ";
-  GLuint texture;
-
-  SDL_Surface *message = NULL;
-  message = TTF_RenderUTF8_Blended( font, text.c_str(), textColor );
-
-
-  // Prepare the texture for the font
-  GLenum textFormat;
-  if(message->format->BytesPerPixel == 4)
-  {
-      // alpha
-      if(message->format->Rmask == 0x000000ff)
-          textFormat = GL_RGBA;
-      else
-          textFormat = GL_BGRA_EXT;
-  }
-
-  // Create the font's texture
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-  glTexImage2D(GL_TEXTURE_2D, 0, message->format->BytesPerPixel, message->w, message->h, 0, textFormat, GL_UNSIGNED_BYTE, message->pixels);
+    if(!font)
+        return;
+    vector<string> lines = frame_stats.getOverlayLines();
+    int line_height = TTF_FontLineSkip(font);
+    for(int i=0;i<(int)lines.size();i++)
+        drawText(font, lines[i], 4, 4 + i * line_height, false, false);
+}
 
-  GLfloat x1=0.f+position_x;
-  if(center_x)
-  {
-      x1+=0.f+screen_width/2-message->w/2;
-  }
-  GLfloat y1=0.f+position_y;
-  if(center_y)
-  {
-      y1+=0.f+screen_height/2-message->h/2;
-  }
-  GLfloat x2=0.f+x1+message->w;
-  GLfloat y2=0.f+y1+message->h;
-  SDL_FreeSurface(message);
-
-
-  //OpenGL draw
-  glBindTexture( GL_TEXTURE_2D, texture );
-  glColor3ub(255, 255, 255);
-  glEnable(GL_TEXTURE_2D);
-  glEnable(GL_BLEND);
-  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-  glBegin( GL_QUADS );
-
-      //Bottom-left vertex (corner)
-      glTexCoord2i( 0, 0 );
-      glVertex3f( x1, y1, 0.0f );
-
-      //Bottom-right vertex (corner)
-      glTexCoord2i( 1, 0 );
-      glVertex3f( x2, y1, 0.f );
-
-      //Top-right vertex (corner)
-      glTexCoord2i( 1, 1 );
-      glVertex3f( x2, y2, 0.f );
-
-      //Top-left vertex (corner)
-      glTexCoord2i( 0, 1 );
-      glVertex3f( x1, y2, 0.f );
-
-  glEnd();
-  glDisable(GL_BLEND);
-  glDisable(GL_TEXTURE_2D);
-  glDeleteTextures( 1, &texture );
+void RosalilaGraphics::drawText(std::string text,int position_x,int position_y, bool center_x, bool center_y)
+{
+  drawText(font, text, position_x, position_y, center_x, center_y);
 }
 
 void RosalilaGraphics::drawText(TTF_Font* font, std::string text, int position_x, int position_y, bool center_x, bool center_y)
 {
-  position_x += screen_shake_effect.current_x;
-  position_y += screen_shake_effect.current_y;
-
-  if(text=="")
-      text=" ";
-  GLuint texture;
-
-  SDL_Surface *message = NULL;
-  message = TTF_RenderUTF8_Blended( font, text.c_str(), textColor );
+  if(!font)
+      return;
 
+  position_x += draw_offset_x;
+  position_y += draw_offset_y;
 
-  // Prepare the texture for the font
-  GLenum textFormat;
-  if(message->format->BytesPerPixel == 4)
+  GLfloat x1=0.f+position_x;
+  GLfloat y1=0.f+position_y;
+  if(center_x || center_y)
   {
-      // alpha
-      if(message->format->Rmask == 0x000000ff)
-          textFormat = GL_RGBA;
-      else
-          textFormat = GL_BGRA_EXT;
+      int text_width = 0;
+      int text_height = 0;
+      TTF_SizeUTF8(font, text.c_str(), &text_width, &text_height);
+      if(center_x)
+      {
+          x1+=0.f+screen_width/2-text_width/2;
+      }
+      if(center_y)
+      {
+          y1+=0.f+screen_height/2-text_height/2;
+      }
   }
 
-  // Create the font's texture
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-  glTexImage2D(GL_TEXTURE_2D, 0, message->format->BytesPerPixel, message->w, message->h, 0, textFormat, GL_UNSIGNED_BYTE, message->pixels);
-
-  GLfloat x1=0.f+position_x;
-  if(center_x)
+  //Long static strings are drawn from a single cached texture
+  if(text_cache.enabled && (int)text.length() >= text_cache.min_length)
   {
-      x1+=0.f+screen_width/2-message->w/2;
+      TextCacheEntry* entry = text_cache.get(font, text, textColor);
+      if(entry)
+      {
+          sprite_batch.draw(entry->texture, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+                            0, 0, 0, false,
+                            x1, y1, x1 + entry->width, y1 + entry->height,
+                            0, 0, 1, 1,
+                            Color(255, 255, 255, 255));
+          return;
+      }
   }
-  GLfloat y1=0.f+position_y;
-  if(center_y)
+
+  //Glyphs are laid out as quads from the glyph atlas, nothing gets uploaded once they are cached
+  Color color(textColor.r, textColor.g, textColor.b, 255);
+  GLfloat pen_x = x1;
+#if SDL_TTF_VERSION_ATLEAST(2,0,14)
+  Uint32 previous_codepoint = 0;
+#else
+  Glyph* previous_glyph = NULL;
+#endif
+  int index = 0;
+  while(index < (int)text.length())
   {
-      y1+=0.f+screen_height/2-message->h/2;
+      Uint32 codepoint = glyph_atlas.nextCodepoint(text, index);
+      Glyph* glyph = glyph_atlas.getGlyph(font, codepoint);
+
+#if SDL_TTF_VERSION_ATLEAST(2,0,14)
+      if(previous_codepoint && codepoint <= 0xFFFF)
+          pen_x += TTF_GetFontKerningSizeGlyphs(font, (Uint16)previous_codepoint, (Uint16)codepoint);
+#else
+      if(previous_glyph)
+          pen_x += TTF_GetFontKerningSize(font, previous_glyph->index, glyph->index);
+#endif
+
+      if(glyph->image)
+      {
+          Image* image = glyph->image;
+          GLfloat glyph_x = pen_x + glyph->offset_x;
+          sprite_batch.draw(image->getTexture(), GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+                            0, 0, 0, false,
+                            glyph_x, y1, glyph_x + image->width, y1 + image->height,
+                            image->uv_x1, image->uv_y1, image->uv_x2, image->uv_y2,
+                            color);
+      }
+
+      pen_x += glyph->advance;
+#if SDL_TTF_VERSION_ATLEAST(2,0,14)
+      previous_codepoint = codepoint;
+#else
+      previous_glyph = glyph;
+#endif
   }
-  GLfloat x2=0.f+x1+message->w;
-  GLfloat y2=0.f+y1+message->h;
-  SDL_FreeSurface(message);
-
-
-  //OpenGL draw
-  glBindTexture( GL_TEXTURE_2D, texture );
-  glColor3ub(255, 255, 255);
-  glEnable(GL_TEXTURE_2D);
-  glEnable(GL_BLEND);
-  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-  glBegin( GL_QUADS );
-
-      //Bottom-left vertex (corner)
-      glTexCoord2i( 0, 0 );
-      glVertex3f( x1, y1, 0.0f );
-
-      //Bottom-right vertex (corner)
-      glTexCoord2i( 1, 0 );
-      glVertex3f( x2, y1, 0.f );
-
-      //Top-right vertex (corner)
-      glTexCoord2i( 1, 1 );
-      glVertex3f( x2, y2, 0.f );
-
-      //Top-left vertex (corner)
-      glTexCoord2i( 0, 1 );
-      glVertex3f( x1, y2, 0.f );
-
-  glEnd();
-  glDisable(GL_BLEND);
-  glDisable(GL_TEXTURE_2D);
-  glDeleteTextures( 1, &texture );
 }
 
 void RosalilaGraphics::updateScreen()
 {
+    ROSALILA_TRACE("RosalilaGraphics::updateScreen");
+    setRenderTarget(NULL);
+
     frameCap();
 
+    image_loader.update();
+
     grayscale_effect.update();
     transparency_effect.update();
     screen_shake_effect.update();
@@ -1176,6 +1375,15 @@ void RosalilaGraphics::updateScreen()
 
     drawPoints(point_explosion_effect->current_points);
 
+    //Without post process the effects of this frame are done on every draw of the next one
+    if(!post_process.supported)
+    {
+        draw_saturation = grayscale_effect.current_percentage;
+        draw_fade = transparency_effect.current_percentage;
+        draw_offset_x = screen_shake_effect.current_x;
+        draw_offset_y = screen_shake_effect.current_y;
+    }
+
     notification_handler.update();
     if(notification_handler.notifications.size()>0)
     {
@@ -1191,13 +1399,95 @@ void RosalilaGraphics::updateScreen()
                                           current_notification->y);
     }
 
-    SDL_GL_SwapWindow(window);
+    if(post_process.scene_active)
+    {
+        switchRenderTarget(NULL);
+        post_process.scene_active = false;
+        float saturation = (float)grayscale_effect.current_percentage;
+        float fade = (float)transparency_effect.current_percentage;
+        if(render_thread.running)
+            render_thread.recordPostProcess(saturation, fade, (float)screen_shake_effect.current_x, (float)screen_shake_effect.current_y);
+        else
+            post_process.render(saturation, fade, (float)screen_shake_effect.current_x, (float)screen_shake_effect.current_y);
+    }
+
+    //Over the post process so it is not grayed out or shaken
+    if(frame_stats.overlay)
+        drawFrameStats();
+
+    sprite_batch.flush();
+    sprite_batch.last_frame_draws_merged = sprite_batch.draws_merged;
+    sprite_batch.draws_merged = 0;
+    if(render_thread.running)
+    {
+        //The render thread swaps, this thread goes on with the next frame
+        render_thread.submitFrame();
+    }
+    else
+    {
+        ROSALILA_TRACE("SDL_GL_SwapWindow");
+        frame_capture.endFrame();
+        SDL_GL_SwapWindow(window);
+        state_cache.endFrame();
+        frame_stats.endGpuFrame();
+    }
     //clearScreen(Color(255,255,255,255));
     clearScreen(Color(0,0,0,0));
+
+    if(post_process.isNeeded(grayscale_effect.current_percentage, transparency_effect.current_percentage,
+                             screen_shake_effect.current_x, screen_shake_effect.current_y))
+    {
+        if(!post_process.scene)
+            post_process.scene = createRenderTarget(screen_width, screen_height);
+        if(post_process.scene)
+        {
+            post_process.scene_active = true;
+            setRenderTarget(NULL);
+            clearScreen(Color(0,0,0,0));
+        }
+    }
 }
 
 
 void RosalilaGraphics::screenshot(int x, int y, int w, int h, string filename)
+{
+    sprite_batch.flush();
+
+    if(render_thread.running)
+        render_thread.recordScreenshot(x, y, w, h, filename);
+    else
+        saveScreenshot(x, y, w, h, filename);
+}
+
+void RosalilaGraphics::screenshotAsync(int x, int y, int w, int h, string filename)
+{
+    sprite_batch.flush();
+
+    if(render_thread.running)
+        render_thread.recordCapture(x, y, w, h, filename);
+    else
+        frame_capture.capture(x, y, w, h, filename);
+}
+
+void RosalilaGraphics::startCapture(string path, string extension)
+{
+    rosalila()->utility->writeLogLine("Capturing frames to "+path);
+    runOnRenderThread([&]()
+    {
+        frame_capture.startRecording(0, 0, screen_width, screen_height, path, extension);
+    });
+}
+
+void RosalilaGraphics::stopCapture()
+{
+    runOnRenderThread([&]()
+    {
+        frame_capture.stopRecording();
+    });
+    rosalila()->utility->writeLogLine("Frame capture stopped after "+rosalila()->utility->toString(frame_capture.recorded_frames)+" frames");
+}
+
+void RosalilaGraphics::saveScreenshot(int x, int y, int w, int h, string filename)
 {
     unsigned char * pixels = new unsigned char[w*h*4]; // 4 bytes for RGBA
     glReadPixels(x,y,w, h, GL_BGRA, GL_UNSIGNED_BYTE, pixels);
@@ -1210,6 +1500,16 @@ void RosalilaGraphics::screenshot(int x, int y, int w, int h, string filename)
 }
 
 void RosalilaGraphics::clearScreen(Color color)
+{
+    sprite_batch.flush();
+
+    if(render_thread.running)
+        render_thread.recordClear(color);
+    else
+        clearColorBuffer(color);
+}
+
+void RosalilaGraphics::clearColorBuffer(Color color)
 {
     float red = ((float)color.red)/255.0f;
     float green = ((float)color.green)/255.0f;
@@ -0,0 +1,73 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+ShaderProgram::ShaderProgram()
+{
+    program = 0;
+}
+
+ShaderProgram::~ShaderProgram()
+{
+    if(program)
+        glDeleteProgram(program);
+}
+
+GLuint ShaderProgram::compile(GLenum type, string source)
+{
+    GLuint shader = glCreateShader(type);
+    const GLchar* source_pointer = source.c_str();
+    glShaderSource(shader, 1, &source_pointer, NULL);
+    glCompileShader(shader);
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if(compiled != GL_TRUE)
+    {
+        GLchar info_log[1024];
+        glGetShaderInfoLog(shader, sizeof(info_log), NULL, info_log);
+        rosalila()->utility->writeLogLine("Error: Could not compile shader: " + string(info_log));
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+bool ShaderProgram::init(string vertex_source, string fragment_source)
+{
+    GLuint vertex_shader = compile(GL_VERTEX_SHADER, vertex_source);
+    GLuint fragment_shader = compile(GL_FRAGMENT_SHADER, fragment_source);
+    if(!vertex_shader || !fragment_shader)
+    {
+        if(vertex_shader)
+            glDeleteShader(vertex_shader);
+        if(fragment_shader)
+            glDeleteShader(fragment_shader);
+        return false;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+
+    //The program keeps them alive while it is attached
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if(linked != GL_TRUE)
+    {
+        GLchar info_log[1024];
+        glGetProgramInfoLog(program, sizeof(info_log), NULL, info_log);
+        rosalila()->utility->writeLogLine("Error: Could not link shader program: " + string(info_log));
+        glDeleteProgram(program);
+        program = 0;
+        return false;
+    }
+    return true;
+}
+
+GLint ShaderProgram::getUniformLocation(string name)
+{
+    return glGetUniformLocation(program, name.c_str());
+}
@@ -0,0 +1,552 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+static const char* sprite_vertex_shader =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 corner;\n"
+    "layout(location = 1) in vec2 texture_coordinate;\n"
+    "layout(location = 2) in vec4 color;\n"
+    "layout(location = 3) in vec3 pivot_rotation;\n"
+    "layout(location = 4) in vec2 flip;\n"
+    "uniform mat4 projection;\n"
+    "out vec2 fragment_texture_coordinate;\n"
+    "out vec4 fragment_color;\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 position = corner;\n"
+    "    if(flip.y > 0.5)\n"
+    "        position.x = 2.0 * flip.x - position.x;\n"
+    "    float angle = radians(-pivot_rotation.z);\n"
+    "    float s = sin(angle);\n"
+    "    float c = cos(angle);\n"
+    "    position = pivot_rotation.xy + vec2(position.x * c - position.y * s, position.x * s + position.y * c);\n"
+    "    gl_Position = projection * vec4(position, 0.0, 1.0);\n"
+    "    fragment_texture_coordinate = texture_coordinate;\n"
+    "    fragment_color = color;\n"
+    "}\n";
+
+//Same as the GL_MODULATE texture environment of the fixed function pipeline
+static const char* sprite_fragment_shader =
+    "#version 330 core\n"
+    "uniform sampler2D image;\n"
+    "in vec2 fragment_texture_coordinate;\n"
+    "in vec4 fragment_color;\n"
+    "out vec4 output_color;\n"
+    "void main()\n"
+    "{\n"
+    "    output_color = texture(image, fragment_texture_coordinate) * fragment_color;\n"
+    "}\n";
+
+static const char* instance_vertex_shader =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 corner;\n"
+    "layout(location = 1) in vec4 transform;\n"
+    "layout(location = 2) in vec4 color;\n"
+    "uniform mat4 projection;\n"
+    "uniform vec2 size;\n"
+    "uniform vec4 texture_rectangle;\n"
+    "uniform float flip;\n"
+    "uniform vec2 offset;\n"
+    "out vec2 fragment_texture_coordinate;\n"
+    "out vec4 fragment_color;\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 scaled_size = size * transform.w;\n"
+    "    vec2 position = (corner - 0.5) * scaled_size;\n"
+    "    if(flip > 0.5)\n"
+    "        position.x = -position.x;\n"
+    "    float angle = radians(-transform.z);\n"
+    "    float s = sin(angle);\n"
+    "    float c = cos(angle);\n"
+    "    position = vec2(position.x * c - position.y * s, position.x * s + position.y * c);\n"
+    "    position += transform.xy + scaled_size / 2.0 + offset;\n"
+    "    gl_Position = projection * vec4(position, 0.0, 1.0);\n"
+    "    fragment_texture_coordinate = mix(texture_rectangle.xy, texture_rectangle.zw, corner);\n"
+    "    fragment_color = color;\n"
+    "}\n";
+
+bool SpriteBatch::init(bool core_profile)
+{
+    this->core_profile = core_profile;
+    this->current_texture = 0;
+    this->current_blend_source = GL_SRC_ALPHA;
+    this->current_blend_destination = GL_ONE_MINUS_SRC_ALPHA;
+    this->vertex_array = 0;
+    this->instance_vertex_array = 0;
+    this->projection_uniform = -1;
+    this->sort_draws = false;
+    this->layer = 0;
+    this->draws_merged = 0;
+    this->last_frame_draws_merged = 0;
+    this->vertices.reserve(sprite_batch_max_quads * 4);
+
+    if(core_profile)
+    {
+        if(!shader_program.init(sprite_vertex_shader, sprite_fragment_shader)
+           || !instance_shader_program.init(instance_vertex_shader, sprite_fragment_shader))
+            return false;
+        projection_uniform = shader_program.getUniformLocation("projection");
+        instance_projection_uniform = instance_shader_program.getUniformLocation("projection");
+        instance_size_uniform = instance_shader_program.getUniformLocation("size");
+        instance_texture_rectangle_uniform = instance_shader_program.getUniformLocation("texture_rectangle");
+        instance_flip_uniform = instance_shader_program.getUniformLocation("flip");
+        instance_offset_uniform = instance_shader_program.getUniformLocation("offset");
+#ifndef OSX
+        glGenVertexArrays(1, &vertex_array);
+        glBindVertexArray(vertex_array);
+#endif
+    }
+
+    glGenBuffers(1, &vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sprite_batch_max_quads * 4 * sizeof(SpriteVertex), NULL, GL_STREAM_DRAW);
+
+    //Every quad is two triangles, the indices never change so they are uploaded once
+    vector<GLushort> indices(sprite_batch_max_quads * 6);
+    for(int i=0;i<sprite_batch_max_quads;i++)
+    {
+        indices[i*6 + 0] = (GLushort)(i*4 + 0);
+        indices[i*6 + 1] = (GLushort)(i*4 + 1);
+        indices[i*6 + 2] = (GLushort)(i*4 + 2);
+        indices[i*6 + 3] = (GLushort)(i*4 + 0);
+        indices[i*6 + 4] = (GLushort)(i*4 + 2);
+        indices[i*6 + 5] = (GLushort)(i*4 + 3);
+    }
+
+    glGenBuffers(1, &index_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), &indices[0], GL_STATIC_DRAW);
+
+    if(core_profile)
+    {
+        //The vertex array remembers the layout and the index buffer
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+        glEnableVertexAttribArray(3);
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (GLvoid*)offsetof(SpriteVertex, x));
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (GLvoid*)offsetof(SpriteVertex, u));
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteVertex), (GLvoid*)offsetof(SpriteVertex, red));
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (GLvoid*)offsetof(SpriteVertex, pivot_x));
+        glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (GLvoid*)offsetof(SpriteVertex, flip_axis));
+#ifndef OSX
+        glBindVertexArray(0);
+#endif
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+#ifndef OSX
+    if(core_profile)
+    {
+        //Triangle strip corners, the instance attributes advance once per copy
+        GLfloat quad[8] = {0, 0, 1, 0, 0, 1, 1, 1};
+        glGenVertexArrays(1, &instance_vertex_array);
+        glBindVertexArray(instance_vertex_array);
+
+        glGenBuffers(1, &quad_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid*)0);
+
+        glGenBuffers(1, &instance_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (GLvoid*)offsetof(SpriteInstance, x));
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteInstance), (GLvoid*)offsetof(SpriteInstance, red));
+        glVertexAttribDivisor(1, 1);
+        glVertexAttribDivisor(2, 1);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+#endif
+
+    GLubyte white_pixel[4] = {255, 255, 255, 255};
+    white_texture = rosalila()->graphics->texture_uploader.createTexture(1, 1, GL_RGBA, GL_RGBA, white_pixel, 4, GL_NEAREST);
+
+    return true;
+}
+
+void SpriteBatch::setSortDraws(bool sort_draws)
+{
+    flush();
+    this->sort_draws = sort_draws;
+}
+
+void SpriteBatch::setState(GLuint texture, GLenum blend_source, GLenum blend_destination)
+{
+    if(sort_draws)
+    {
+        //Called once per quad, right before its vertices are added
+        int blend_function = 0;
+        while(blend_function < (int)sort_blend_functions.size()
+              && (sort_blend_functions[blend_function].first != blend_source
+                  || sort_blend_functions[blend_function].second != blend_destination))
+            blend_function++;
+        if(blend_function == (int)sort_blend_functions.size())
+        {
+            //More than 256 blend functions on a frame, start a new sort
+            if(blend_function == 256)
+            {
+                flush();
+                blend_function = 0;
+            }
+            sort_blend_functions.push_back(make_pair(blend_source, blend_destination));
+        }
+
+        SortedQuad sorted_quad;
+        sorted_quad.key = ((uint64_t)((layer + 0x800000) & 0xFFFFFF) << 40)
+                        | ((uint64_t)blend_function << 32)
+                        | (uint64_t)texture;
+        sorted_quad.quad = (int)sort_keys.size();
+        sort_keys.push_back(sorted_quad);
+        current_texture = texture;
+        current_blend_source = blend_source;
+        current_blend_destination = blend_destination;
+        return;
+    }
+
+    if(texture != current_texture
+       || blend_source != current_blend_source
+       || blend_destination != current_blend_destination
+       || (int)vertices.size() >= sprite_batch_max_quads * 4)
+    {
+        flush();
+        current_texture = texture;
+        current_blend_source = blend_source;
+        current_blend_destination = blend_destination;
+    }
+}
+
+void SpriteBatch::draw(GLuint texture, GLenum blend_source, GLenum blend_destination,
+                       float pivot_x, float pivot_y, float rotation, bool flip,
+                       float x1, float y1, float x2, float y2,
+                       float u1, float v1, float u2, float v2,
+                       Color color)
+{
+    setState(texture, blend_source, blend_destination);
+
+    SpriteVertex vertex;
+    vertex.red = (GLubyte)color.red;
+    vertex.green = (GLubyte)color.green;
+    vertex.blue = (GLubyte)color.blue;
+    vertex.alpha = (GLubyte)color.alpha;
+
+    float corners_u[4] = {u1, u2, u2, u1};
+    float corners_v[4] = {v1, v1, v2, v2};
+
+    if(core_profile)
+    {
+        //The vertex shader does the rest
+        float corners_x[4] = {x1, x2, x2, x1};
+        float corners_y[4] = {y1, y1, y2, y2};
+        vertex.pivot_x = pivot_x;
+        vertex.pivot_y = pivot_y;
+        vertex.rotation = rotation;
+        vertex.flip_axis = (x1 + x2) / 2;
+        vertex.flip = flip ? 1.0f : 0.0f;
+        for(int i=0;i<4;i++)
+        {
+            vertex.x = corners_x[i];
+            vertex.y = corners_y[i];
+            vertex.u = corners_u[i];
+            vertex.v = corners_v[i];
+            vertices.push_back(vertex);
+        }
+        return;
+    }
+
+    if(flip)
+    {
+        float temp = x1;
+        x1 = x2;
+        x2 = temp;
+    }
+
+    float s = 0;
+    float c = 1;
+    if(rotation != 0)
+    {
+        s = (float)sin(-rotation*PI/180);
+        c = (float)cos(-rotation*PI/180);
+    }
+
+    float corners_x[4] = {x1, x2, x2, x1};
+    float corners_y[4] = {y1, y1, y2, y2};
+
+    vertex.pivot_x = 0;
+    vertex.pivot_y = 0;
+    vertex.rotation = 0;
+    vertex.flip_axis = 0;
+    vertex.flip = 0;
+    for(int i=0;i<4;i++)
+    {
+        vertex.x = pivot_x + corners_x[i] * c - corners_y[i] * s;
+        vertex.y = pivot_y + corners_x[i] * s + corners_y[i] * c;
+        vertex.u = corners_u[i];
+        vertex.v = corners_v[i];
+        vertices.push_back(vertex);
+    }
+}
+
+void SpriteBatch::drawShape(float* points_x, float* points_y, int points_count, Color color)
+{
+    setState(white_texture, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    SpriteVertex vertex;
+    vertex.u = 0.5f;
+    vertex.v = 0.5f;
+    vertex.red = (GLubyte)color.red;
+    vertex.green = (GLubyte)color.green;
+    vertex.blue = (GLubyte)color.blue;
+    vertex.alpha = (GLubyte)color.alpha;
+    vertex.pivot_x = 0;
+    vertex.pivot_y = 0;
+    vertex.rotation = 0;
+    vertex.flip_axis = 0;
+    vertex.flip = 0;
+
+    //Triangles repeat the last point so the second half of the quad is degenerate
+    for(int i=0;i<4;i++)
+    {
+        int point = i < points_count ? i : points_count - 1;
+        vertex.x = points_x[point];
+        vertex.y = points_y[point];
+        vertices.push_back(vertex);
+    }
+}
+
+void SpriteBatch::drawInstances(GLuint texture, GLenum blend_source, float width, float height,
+                                float u1, float v1, float u2, float v2, bool flip,
+                                float offset_x, float offset_y,
+                                const SpriteInstance* instances, int count)
+{
+    if(count <= 0)
+        return;
+
+#ifndef OSX
+    if(core_profile)
+    {
+        //Keep the drawing order
+        flush();
+
+        RenderThread* render_thread = &rosalila()->graphics->render_thread;
+        if(render_thread->running)
+            render_thread->recordInstances(texture, blend_source, width, height, u1, v1, u2, v2, flip, offset_x, offset_y, instances, count);
+        else
+            renderInstances(texture, blend_source, width, height, u1, v1, u2, v2, flip, offset_x, offset_y, instances, count);
+        return;
+    }
+#endif
+
+    for(int i=0;i<count;i++)
+    {
+        const SpriteInstance& instance = instances[i];
+        float half_width = width * instance.scale / 2;
+        float half_height = height * instance.scale / 2;
+        Color color(instance.red, instance.green, instance.blue, instance.alpha);
+        draw(texture, blend_source, GL_ONE_MINUS_SRC_ALPHA,
+             instance.x + half_width + offset_x, instance.y + half_height + offset_y, instance.rotation, flip,
+             -half_width, -half_height, half_width, half_height,
+             u1, v1, u2, v2,
+             color);
+    }
+}
+
+void SpriteBatch::flush()
+{
+    ROSALILA_TRACE("SpriteBatch::flush");
+    if(vertices.empty())
+        return;
+
+    if(!sort_keys.empty())
+    {
+        flushSorted();
+        return;
+    }
+
+    submit(current_texture, current_blend_source, current_blend_destination, &vertices[0], (int)vertices.size());
+    vertices.clear();
+}
+
+void SpriteBatch::flushSorted()
+{
+    int count = (int)sort_keys.size();
+    const uint64_t state_mask = 0xFFFFFFFFFFULL;
+
+    //Draw calls needed on the order the quads were drawn
+    int unsorted_draws = 1;
+    for(int i=1;i<count;i++)
+        if((sort_keys[i].key & state_mask) != (sort_keys[i-1].key & state_mask))
+            unsorted_draws++;
+
+    //One byte per pass starting from the lowest, each pass is a stable counting sort
+    sort_scratch.resize(count);
+    SortedQuad* source = &sort_keys[0];
+    SortedQuad* destination = &sort_scratch[0];
+    for(int shift=0;shift<64;shift+=8)
+    {
+        int offsets[256] = {0};
+        for(int i=0;i<count;i++)
+            offsets[(source[i].key >> shift) & 0xFF]++;
+        //Every key has the same byte here, the pass would not move anything
+        if(offsets[(source[0].key >> shift) & 0xFF] == count)
+            continue;
+        int offset = 0;
+        for(int digit=0;digit<256;digit++)
+        {
+            int digit_count = offsets[digit];
+            offsets[digit] = offset;
+            offset += digit_count;
+        }
+        for(int i=0;i<count;i++)
+            destination[offsets[(source[i].key >> shift) & 0xFF]++] = source[i];
+        SortedQuad* temp = source;
+        source = destination;
+        destination = temp;
+    }
+
+    sorted_vertices.resize(vertices.size());
+    for(int i=0;i<count;i++)
+        memcpy(&sorted_vertices[i*4], &vertices[source[i].quad*4], 4 * sizeof(SpriteVertex));
+
+    //Merge pass, every run with the same texture and blend function goes on a single call
+    int sorted_draws = 0;
+    int run_start = 0;
+    for(int i=1;i<=count;i++)
+    {
+        if(i == count
+           || (source[i].key & state_mask) != (source[run_start].key & state_mask)
+           || i - run_start == sprite_batch_max_quads)
+        {
+            pair<GLenum,GLenum>& blend_function = sort_blend_functions[(source[run_start].key >> 32) & 0xFF];
+            submit((GLuint)(source[run_start].key & 0xFFFFFFFF), blend_function.first, blend_function.second,
+                   &sorted_vertices[run_start*4], (i - run_start) * 4);
+            sorted_draws++;
+            run_start = i;
+        }
+    }
+
+    if(unsorted_draws > sorted_draws)
+        draws_merged += unsorted_draws - sorted_draws;
+
+    vertices.clear();
+    sort_keys.clear();
+    sort_blend_functions.clear();
+}
+
+void SpriteBatch::submit(GLuint texture, GLenum blend_source, GLenum blend_destination,
+                         const SpriteVertex* vertices, int count)
+{
+    RenderThread* render_thread = &rosalila()->graphics->render_thread;
+    if(render_thread->running)
+        render_thread->recordSprites(texture, blend_source, blend_destination, vertices, count);
+    else
+        renderVertices(texture, blend_source, blend_destination, vertices, count);
+}
+
+void SpriteBatch::renderInstances(GLuint texture, GLenum blend_source, float width, float height,
+                                  float u1, float v1, float u2, float v2, bool flip,
+                                  float offset_x, float offset_y,
+                                  const SpriteInstance* instances, int count)
+{
+#ifndef OSX
+    RosalilaGraphics* graphics = rosalila()->graphics;
+    GraphicsStateCache* state_cache = &graphics->state_cache;
+
+    state_cache->useProgram(instance_shader_program.program, instance_projection_uniform);
+    state_cache->orthoProjection(graphics->target_width, graphics->target_height, graphics->target_bottom_up);
+    state_cache->disable(GL_DEPTH_TEST);
+    state_cache->enable(GL_BLEND);
+    state_cache->blendFunction(blend_source, GL_ONE_MINUS_SRC_ALPHA);
+    state_cache->bindTexture(texture);
+
+    glUniform2f(instance_size_uniform, width, height);
+    glUniform4f(instance_texture_rectangle_uniform, u1, v1, u2, v2);
+    glUniform1f(instance_flip_uniform, flip ? 1.0f : 0.0f);
+    glUniform2f(instance_offset_uniform, offset_x, offset_y);
+
+    glBindVertexArray(instance_vertex_array);
+    //A new store every call, the driver hands out fresh memory instead of waiting for the last draw
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(SpriteInstance), instances, GL_STREAM_DRAW);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+    graphics->frame_stats.draw_calls++;
+    graphics->frame_stats.vertices += count * 4;
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+#endif
+}
+
+void SpriteBatch::renderVertices(GLuint texture, GLenum blend_source, GLenum blend_destination,
+                                 const SpriteVertex* vertices, int count)
+{
+    RosalilaGraphics* graphics = rosalila()->graphics;
+    GraphicsStateCache* state_cache = &graphics->state_cache;
+
+    if(core_profile)
+    {
+        state_cache->useProgram(shader_program.program, projection_uniform);
+        state_cache->orthoProjection(graphics->target_width, graphics->target_height, graphics->target_bottom_up);
+    }
+    else
+    {
+        state_cache->enable( GL_TEXTURE_2D );
+
+        state_cache->orthoProjection(graphics->target_width, graphics->target_height, graphics->target_bottom_up);
+        state_cache->loadModelviewIdentity();
+
+        state_cache->disable(GL_LIGHTING);
+        state_cache->enable(GL_LIGHT0);
+    }
+    state_cache->disable(GL_DEPTH_TEST);
+
+    state_cache->enable(GL_BLEND);
+    state_cache->blendFunction(blend_source, blend_destination);
+    state_cache->bindTexture(texture);
+
+#ifndef OSX
+    if(core_profile)
+        glBindVertexArray(vertex_array);
+#endif
+
+    //New storage sized to this batch, the driver does not wait for the last draw to finish
+    //and small batches do not reallocate the whole buffer
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(SpriteVertex), vertices, GL_STREAM_DRAW);
+    graphics->frame_stats.draw_calls++;
+    graphics->frame_stats.vertices += count;
+
+    if(core_profile)
+    {
+        glDrawElements(GL_TRIANGLES, (GLsizei)(count / 4 * 6), GL_UNSIGNED_SHORT, 0);
+#ifndef OSX
+        glBindVertexArray(0);
+#endif
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(SpriteVertex), (GLvoid*)offsetof(SpriteVertex, x));
+    glTexCoordPointer(2, GL_FLOAT, sizeof(SpriteVertex), (GLvoid*)offsetof(SpriteVertex, u));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(SpriteVertex), (GLvoid*)offsetof(SpriteVertex, red));
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+    glDrawElements(GL_TRIANGLES, (GLsizei)(count / 4 * 6), GL_UNSIGNED_SHORT, 0);
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    //The color array leaves the current color undefined
+    state_cache->forgetColor();
+}
@@ -0,0 +1,112 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+bool TextCacheKey::operator<(const TextCacheKey& other) const
+{
+    if(font != other.font)
+        return font < other.font;
+    if(size != other.size)
+        return size < other.size;
+    if(style != other.style)
+        return style < other.style;
+    if(outline != other.outline)
+        return outline < other.outline;
+    if(red != other.red)
+        return red < other.red;
+    if(green != other.green)
+        return green < other.green;
+    if(blue != other.blue)
+        return blue < other.blue;
+    return text < other.text;
+}
+
+TextCache::TextCache()
+{
+    enabled = false;
+    max_memory = 0;
+    min_length = 0;
+    memory_used = 0;
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+}
+
+void TextCache::init(bool enabled, int max_memory, int min_length)
+{
+    this->enabled = enabled;
+    this->max_memory = max_memory;
+    this->min_length = min_length;
+}
+
+TextCacheEntry* TextCache::get(TTF_Font* font, const string& text, SDL_Color color)
+{
+    TextCacheKey key;
+    key.font = font;
+    key.size = TTF_FontHeight(font);
+    key.style = TTF_GetFontStyle(font);
+    key.outline = TTF_GetFontOutline(font);
+    key.text = text;
+    key.red = color.r;
+    key.green = color.g;
+    key.blue = color.b;
+
+    map<TextCacheKey, list<TextCacheEntry>::iterator>::iterator it = index.find(key);
+    if(it != index.end())
+    {
+        hits++;
+        entries.splice(entries.begin(), entries, it->second);
+        return &entries.front();
+    }
+
+    misses++;
+    SDL_Surface *message = TTF_RenderUTF8_Blended( font, text.c_str(), color );
+    if(!message)
+        return NULL;
+
+    GLenum textFormat = GL_RGBA;
+    if(message->format->Rmask != 0x000000ff)
+        textFormat = GL_BGRA;
+
+    TextCacheEntry entry;
+    entry.key = key;
+    entry.width = message->w;
+    entry.height = message->h;
+    entry.memory = message->w * message->h * 4;
+
+    rosalila()->graphics->runOnRenderThread([&]()
+    {
+        entry.texture = rosalila()->graphics->texture_uploader.createTexture(message->w, message->h, GL_RGBA, textFormat,
+                                                                             message->pixels, message->pitch, GL_LINEAR);
+    });
+    SDL_FreeSurface(message);
+
+    entries.push_front(entry);
+    index[key] = entries.begin();
+    memory_used += entry.memory;
+
+    evict();
+    return &entries.front();
+}
+
+void TextCache::evict()
+{
+    //The newest entry stays even if it is bigger than the whole budget
+    while(memory_used > max_memory && entries.size() > 1)
+    {
+        TextCacheEntry& oldest = entries.back();
+        rosalila()->graphics->deleteTexture(oldest.texture);
+        memory_used -= oldest.memory;
+        index.erase(oldest.key);
+        entries.pop_back();
+        evictions++;
+    }
+}
+
+void TextCache::clear()
+{
+    rosalila()->graphics->sprite_batch.flush();
+    for(list<TextCacheEntry>::iterator i=entries.begin();i!=entries.end();i++)
+        rosalila()->graphics->deleteTexture(i->texture);
+    entries.clear();
+    index.clear();
+    memory_used = 0;
+}
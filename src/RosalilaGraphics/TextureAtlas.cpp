@@ -0,0 +1,104 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+TextureAtlas::TextureAtlas(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+
+    SkylineNode node;
+    node.x = 0;
+    node.y = 0;
+    node.width = width;
+    skyline.push_back(node);
+
+    //Start fully transparent so the padding between images never shows garbage
+    vector<GLubyte> pixels(width * height * 4, 0);
+
+    texture = rosalila()->graphics->texture_uploader.createTexture(width, height, GL_RGBA, GL_RGBA, &pixels[0], width * 4, GL_LINEAR);
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    rosalila()->graphics->deleteTexture(texture);
+}
+
+int TextureAtlas::fit(int node_index, int width, int height)
+{
+    int x = skyline[node_index].x;
+    if(x + width > this->width)
+        return -1;
+
+    int y = skyline[node_index].y;
+    int width_left = width;
+    int i = node_index;
+    while(width_left > 0)
+    {
+        if(skyline[i].y > y)
+            y = skyline[i].y;
+        if(y + height > this->height)
+            return -1;
+        width_left -= skyline[i].width;
+        i++;
+    }
+    return y;
+}
+
+bool TextureAtlas::insert(int width, int height, int &x, int &y)
+{
+    int best_index = -1;
+    int best_bottom = this->height + 1;
+    int best_width = this->width + 1;
+
+    for(int i=0;i<(int)skyline.size();i++)
+    {
+        int node_y = fit(i, width, height);
+        if(node_y == -1)
+            continue;
+        if(node_y + height < best_bottom
+           || (node_y + height == best_bottom && skyline[i].width < best_width))
+        {
+            best_index = i;
+            best_bottom = node_y + height;
+            best_width = skyline[i].width;
+            x = skyline[i].x;
+            y = node_y;
+        }
+    }
+
+    if(best_index == -1)
+        return false;
+
+    SkylineNode node;
+    node.x = x;
+    node.y = y + height;
+    node.width = width;
+    skyline.insert(skyline.begin() + best_index, node);
+
+    //Shrink or remove the nodes now covered by the new one
+    for(int i=best_index+1;i<(int)skyline.size();i++)
+    {
+        int previous_end = skyline[i-1].x + skyline[i-1].width;
+        if(skyline[i].x >= previous_end)
+            break;
+        int shrink = previous_end - skyline[i].x;
+        skyline[i].x += shrink;
+        skyline[i].width -= shrink;
+        if(skyline[i].width > 0)
+            break;
+        skyline.erase(skyline.begin() + i);
+        i--;
+    }
+
+    //Merge neighbours at the same height
+    for(int i=0;i<(int)skyline.size()-1;i++)
+    {
+        if(skyline[i].y == skyline[i+1].y)
+        {
+            skyline[i].width += skyline[i+1].width;
+            skyline.erase(skyline.begin() + i + 1);
+            i--;
+        }
+    }
+
+    return true;
+}
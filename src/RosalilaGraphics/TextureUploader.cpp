@@ -0,0 +1,184 @@
+#include "RosalilaGraphics/RosalilaGraphics.h"
+
+static int getBytesPerPixel(GLenum format)
+{
+    if(format == GL_RGB || format == GL_BGR)
+        return 3;
+    if(format == GL_ALPHA || format == GL_LUMINANCE)
+        return 1;
+    return 4;
+}
+
+//Rows of the surfaces are padded, GL gets them tightly packed
+static void copyRows(GLubyte* destination, const void* pixels, int width, int height, int bytes_per_pixel, int pitch)
+{
+    int row_size = width * bytes_per_pixel;
+    for(int row=0;row<height;row++)
+        memcpy(destination + row * row_size, (const GLubyte*)pixels + row * pitch, row_size);
+}
+
+TextureUploader::TextureUploader()
+{
+    use_fences = false;
+    next_buffer = 0;
+    buffered_uploads = 0;
+    direct_uploads = 0;
+    orphaned_buffers = 0;
+    for(int i=0;i<texture_uploader_buffer_count;i++)
+    {
+        buffers[i] = 0;
+        buffer_sizes[i] = 0;
+#ifndef OSX
+        fences[i] = 0;
+#endif
+    }
+}
+
+void TextureUploader::init(bool use_fences)
+{
+#ifdef OSX
+    use_fences = false;
+#endif
+    this->use_fences = use_fences;
+    next_buffer = 0;
+    glGenBuffers(texture_uploader_buffer_count, buffers);
+    for(int i=0;i<texture_uploader_buffer_count;i++)
+        buffer_sizes[i] = 0;
+}
+
+GLuint TextureUploader::createTexture(int width, int height, GLint internal_format, GLenum format,
+                                      const void* pixels, int pitch, GLint filter)
+{
+    int bytes_per_pixel = getBytesPerPixel(format);
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    rosalila()->graphics->state_cache.bindTexture(texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if(pixels && fillBuffer(width, height, bytes_per_pixel, pixels, pitch))
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, GL_UNSIGNED_BYTE, (GLvoid*)0);
+        releaseBuffer();
+    }
+    else if(!pixels || pitch == width * bytes_per_pixel)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+        if(pixels)
+            direct_uploads++;
+    }
+    else
+    {
+        vector<GLubyte> packed(width * height * bytes_per_pixel);
+        copyRows(&packed[0], pixels, width, height, bytes_per_pixel, pitch);
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, GL_UNSIGNED_BYTE, &packed[0]);
+        direct_uploads++;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if(pixels)
+        rosalila()->graphics->frame_stats.texture_uploads++;
+
+    return texture;
+}
+
+void TextureUploader::updateTexture(GLuint texture, int x, int y, int width, int height, GLenum format,
+                                    const void* pixels, int pitch)
+{
+    int bytes_per_pixel = getBytesPerPixel(format);
+
+    rosalila()->graphics->state_cache.bindTexture(texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if(fillBuffer(width, height, bytes_per_pixel, pixels, pitch))
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, (GLvoid*)0);
+        releaseBuffer();
+    }
+    else if(pitch == width * bytes_per_pixel)
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, pixels);
+        direct_uploads++;
+    }
+    else
+    {
+        vector<GLubyte> packed(width * height * bytes_per_pixel);
+        copyRows(&packed[0], pixels, width, height, bytes_per_pixel, pitch);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, &packed[0]);
+        direct_uploads++;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    rosalila()->graphics->frame_stats.texture_uploads++;
+}
+
+bool TextureUploader::fillBuffer(int width, int height, int bytes_per_pixel, const void* pixels, int pitch)
+{
+    int size = width * height * bytes_per_pixel;
+    if(size <= 0 || size > texture_uploader_max_buffer_size || buffers[next_buffer] == 0)
+        return false;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[next_buffer]);
+    bool grown = false;
+    if(size > buffer_sizes[next_buffer])
+    {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        buffer_sizes[next_buffer] = size;
+        grown = true;
+    }
+
+    GLubyte* mapped = NULL;
+#ifndef OSX
+    if(use_fences)
+    {
+        GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+        if(fences[next_buffer])
+        {
+            GLenum status = glClientWaitSync(fences[next_buffer], 0, 0);
+            if(status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+            {
+                //GL is done reading it, no need to synchronize
+                access |= GL_MAP_UNSYNCHRONIZED_BIT;
+            }
+            else if(!grown)
+            {
+                access |= GL_MAP_INVALIDATE_BUFFER_BIT;
+                orphaned_buffers++;
+            }
+            glDeleteSync(fences[next_buffer]);
+            fences[next_buffer] = 0;
+        }
+        else
+        {
+            access |= GL_MAP_UNSYNCHRONIZED_BIT;
+        }
+        mapped = (GLubyte*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, access);
+    }
+    else
+#endif
+    {
+        //New storage, GL keeps the old one until the uploads reading it are done
+        if(!grown)
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, buffer_sizes[next_buffer], NULL, GL_STREAM_DRAW);
+        mapped = (GLubyte*)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    }
+
+    if(!mapped)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    copyRows(mapped, pixels, width, height, bytes_per_pixel, pitch);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    return true;
+}
+
+void TextureUploader::releaseBuffer()
+{
+#ifndef OSX
+    if(use_fences)
+        fences[next_buffer] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    next_buffer = (next_buffer + 1) % texture_uploader_buffer_count;
+    buffered_uploads++;
+}
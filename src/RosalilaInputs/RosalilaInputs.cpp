@@ -253,6 +253,7 @@ bool RosalilaReceiver::isJoyPressed(int gamepad_number, int joyCode)
 
 void RosalilaReceiver::updateInputs()
 {
+  ROSALILA_TRACE("RosalilaReceiver::updateInputs");
   //While there's events to handle
   SDL_Event event;
   while (SDL_PollEvent(&event))
@@ -275,7 +276,7 @@ void RosalilaReceiver::updateInputs()
       else if (event.key.keysym.sym < 322)
         is_key_pressed[event.key.keysym.sym] = true;
       else
-        rosalila()->utility->writeLogLine("Key pressed but not supported:" + rosalila()->utility->toString(event.key.keysym.sym));
+        rosalila()->utility->writeLogLine(LOG_DEBUG, "Key pressed but not supported:" + rosalila()->utility->toString(event.key.keysym.sym));
     }
     if (event.type == SDL_KEYUP)
     {
@@ -290,7 +291,7 @@ void RosalilaReceiver::updateInputs()
       else if (event.key.keysym.sym < 322)
         is_key_pressed[event.key.keysym.sym] = false;
       else
-        rosalila()->utility->writeLogLine("Key pressed but not supported:" + rosalila()->utility->toString(event.key.keysym.sym));
+        rosalila()->utility->writeLogLine(LOG_DEBUG, "Key pressed but not supported:" + rosalila()->utility->toString(event.key.keysym.sym));
     }
     if (event.type == SDL_JOYBUTTONDOWN)
     {
@@ -38,6 +38,7 @@ Node *jsonToNode(nlohmann::json json_object)
 
 Node *RosalilaParser::getNodes(string file_name)
 {
+  ROSALILA_TRACE("RosalilaParser::getNodes");
   rosalila()->utility->writeLogLine("Parsing: " + file_name);
 
   std::ifstream ifs(file_name);
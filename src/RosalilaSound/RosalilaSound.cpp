@@ -5,6 +5,7 @@ void RosalilaSound::init()
   music=NULL;
   if( Mix_OpenAudio( 44100, AUDIO_S16SYS/*MIX_DEFAULT_FORMAT*/, 2, 512 ) == -1 )
   {
+      rosalila()->utility->writeLogLine("Warning: Could not open the audio device, sounds will not play.");
       return;
   }
   Mix_AllocateChannels(100);
@@ -20,6 +21,7 @@ void RosalilaSound::drop()
 }
 void RosalilaSound::addSound(std::string variable,std::string value)
 {
+  ROSALILA_TRACE("RosalilaSound::addSound");
   if(!rosalila()->utility->fileExists(value.c_str()))
   {
     rosalila()->utility->writeLogLine("Warning: " + value + " does not exist. Could not load sound.");
@@ -69,6 +71,7 @@ void RosalilaSound::stopSound(int channel)
 
 void RosalilaSound::playMusic(std::string path,int loops)
 {
+  ROSALILA_TRACE("RosalilaSound::playMusic");
   stopMusic();
   rosalila()->utility->writeLogLine("Playing music: "+path);
   music = Mix_LoadMUS(path.c_str());
@@ -111,6 +114,7 @@ void RosalilaSound::fadeMusicVolume(int volume, int velocity)
 
 void RosalilaSound::update()
 {
+  ROSALILA_TRACE("RosalilaSound::update");
   int new_volume;
   if(rosalila()->sound->getMusicVolume() < target_fade_volume)
   {
@@ -0,0 +1,380 @@
+#include "RosalilaUtility/RosalilaUtility.h"
+
+//Perimeter, cheaper than the area and works the same to pick where leaves go
+static float getCost(float min_x, float min_y, float max_x, float max_y)
+{
+    return 2 * ((max_x - min_x) + (max_y - min_y));
+}
+
+static float getCombinedCost(const AabbTreeNode& node1, const AabbTreeNode& node2)
+{
+    return getCost(min(node1.min_x, node2.min_x), min(node1.min_y, node2.min_y),
+                   max(node1.max_x, node2.max_x), max(node1.max_y, node2.max_y));
+}
+
+static bool boundsOverlap(const AabbTreeNode& node, float min_x, float min_y, float max_x, float max_y)
+{
+    return node.min_x <= max_x && min_x <= node.max_x
+           && node.min_y <= max_y && min_y <= node.max_y;
+}
+
+//Clips the enter and exit fractions of the ray to one axis of a box
+static bool clipRay(float origin, float direction, float minimum, float maximum, float& enter, float& exit)
+{
+    if(fabsf(direction) < 1e-9f)
+        return origin >= minimum && origin <= maximum;
+    float fraction1 = (minimum - origin) / direction;
+    float fraction2 = (maximum - origin) / direction;
+    if(fraction1 > fraction2)
+        swap(fraction1, fraction2);
+    enter = max(enter, fraction1);
+    exit = min(exit, fraction2);
+    return enter <= exit;
+}
+
+AabbTree::AabbTree()
+{
+    root = aabb_tree_null_node;
+    free_list = aabb_tree_null_node;
+    margin = aabb_tree_default_margin;
+    leaf_count = 0;
+    moved_leaves = 0;
+}
+
+AabbTree::AabbTree(float margin)
+{
+    root = aabb_tree_null_node;
+    free_list = aabb_tree_null_node;
+    this->margin = margin;
+    leaf_count = 0;
+    moved_leaves = 0;
+}
+
+int AabbTree::insert(Hitbox* hitbox, void* data)
+{
+    int leaf = allocateNode();
+    AabbTreeNode& node = nodes[leaf];
+    node.hitbox = hitbox;
+    node.data = data;
+    const OrientedBox& box = hitbox->getBox();
+    node.min_x = box.min_x - margin;
+    node.min_y = box.min_y - margin;
+    node.max_x = box.max_x + margin;
+    node.max_y = box.max_y + margin;
+    insertLeaf(leaf);
+    leaf_count++;
+    return leaf;
+}
+
+bool AabbTree::update(int handle)
+{
+    AabbTreeNode& node = nodes[handle];
+    const OrientedBox& box = node.hitbox->getBox();
+    if(node.min_x <= box.min_x && node.min_y <= box.min_y
+       && box.max_x <= node.max_x && box.max_y <= node.max_y)
+        return false;
+
+    removeLeaf(handle);
+    node.min_x = box.min_x - margin;
+    node.min_y = box.min_y - margin;
+    node.max_x = box.max_x + margin;
+    node.max_y = box.max_y + margin;
+    insertLeaf(handle);
+    moved_leaves++;
+    return true;
+}
+
+void AabbTree::remove(int handle)
+{
+    if(handle < 0 || handle >= (int)nodes.size() || nodes[handle].height != 0)
+        return;
+    removeLeaf(handle);
+    freeNode(handle);
+    leaf_count--;
+}
+
+void AabbTree::clear()
+{
+    nodes.clear();
+    root = aabb_tree_null_node;
+    free_list = aabb_tree_null_node;
+    leaf_count = 0;
+}
+
+Hitbox* AabbTree::getHitbox(int handle)
+{
+    return nodes[handle].hitbox;
+}
+
+void* AabbTree::getData(int handle)
+{
+    return nodes[handle].data;
+}
+
+int AabbTree::getHeight()
+{
+    if(root == aabb_tree_null_node)
+        return 0;
+    return nodes[root].height;
+}
+
+void AabbTree::query(const OrientedBox& box, vector<int>& handles)
+{
+    ROSALILA_TRACE("AabbTree::query");
+    handles.clear();
+    if(root == aabb_tree_null_node)
+        return;
+
+    stack.clear();
+    stack.push_back(root);
+    while(!stack.empty())
+    {
+        int index = stack.back();
+        stack.pop_back();
+        const AabbTreeNode& node = nodes[index];
+        if(!boundsOverlap(node, box.min_x, box.min_y, box.max_x, box.max_y))
+            continue;
+
+        if(node.child1 == aabb_tree_null_node)
+        {
+            if(box.overlaps(node.hitbox->getBox()))
+                handles.push_back(index);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+int AabbTree::raycast(float from_x, float from_y, float to_x, float to_y, float* fraction)
+{
+    ROSALILA_TRACE("AabbTree::raycast");
+    float direction_x = to_x - from_x;
+    float direction_y = to_y - from_y;
+    int closest = aabb_tree_null_node;
+    //Nodes farther than the closest hit so far are skipped
+    float closest_fraction = 1;
+
+    if(root == aabb_tree_null_node)
+        return closest;
+
+    stack.clear();
+    stack.push_back(root);
+    while(!stack.empty())
+    {
+        int index = stack.back();
+        stack.pop_back();
+        const AabbTreeNode& node = nodes[index];
+
+        float enter = 0;
+        float exit = closest_fraction;
+        if(!clipRay(from_x, direction_x, node.min_x, node.max_x, enter, exit)
+           || !clipRay(from_y, direction_y, node.min_y, node.max_y, enter, exit))
+            continue;
+
+        if(node.child1 != aabb_tree_null_node)
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+            continue;
+        }
+
+        //The hitbox is turned, clip the ray on its own axes from its center
+        const OrientedBox& box = node.hitbox->getBox();
+        float origin_x = from_x - box.center_x;
+        float origin_y = from_y - box.center_y;
+        enter = 0;
+        exit = closest_fraction;
+        if(!clipRay(origin_x * box.axis_x[0] + origin_y * box.axis_y[0],
+                    direction_x * box.axis_x[0] + direction_y * box.axis_y[0],
+                    -box.half_extent[0], box.half_extent[0], enter, exit)
+           || !clipRay(origin_x * box.axis_x[1] + origin_y * box.axis_y[1],
+                       direction_x * box.axis_x[1] + direction_y * box.axis_y[1],
+                       -box.half_extent[1], box.half_extent[1], enter, exit))
+            continue;
+
+        closest = index;
+        closest_fraction = enter;
+    }
+
+    if(fraction)
+        *fraction = closest_fraction;
+    return closest;
+}
+
+int AabbTree::allocateNode()
+{
+    if(free_list == aabb_tree_null_node)
+    {
+        nodes.push_back(AabbTreeNode());
+        nodes.back().parent = aabb_tree_null_node;
+        free_list = (int)nodes.size() - 1;
+    }
+
+    int index = free_list;
+    AabbTreeNode& node = nodes[index];
+    free_list = node.parent;
+    node.parent = aabb_tree_null_node;
+    node.child1 = aabb_tree_null_node;
+    node.child2 = aabb_tree_null_node;
+    node.height = 0;
+    node.hitbox = NULL;
+    node.data = NULL;
+    return index;
+}
+
+void AabbTree::freeNode(int index)
+{
+    nodes[index].parent = free_list;
+    nodes[index].height = -1;
+    nodes[index].hitbox = NULL;
+    free_list = index;
+}
+
+void AabbTree::insertLeaf(int leaf)
+{
+    if(root == aabb_tree_null_node)
+    {
+        root = leaf;
+        nodes[root].parent = aabb_tree_null_node;
+        return;
+    }
+
+    //Goes down to the sibling that grows the tree bounds the least
+    int index = root;
+    while(nodes[index].child1 != aabb_tree_null_node)
+    {
+        const AabbTreeNode& node = nodes[index];
+        const AabbTreeNode& leaf_node = nodes[leaf];
+        float cost = getCost(node.min_x, node.min_y, node.max_x, node.max_y);
+        float combined_cost = getCombinedCost(node, leaf_node);
+        //Pairing here makes a new parent for both
+        float pair_cost = 2 * combined_cost;
+        //Every node below grows by at least this much
+        float inherited_cost = 2 * (combined_cost - cost);
+
+        float child_costs[2];
+        int children[2] = {node.child1, node.child2};
+        for(int i=0;i<2;i++)
+        {
+            const AabbTreeNode& child = nodes[children[i]];
+            child_costs[i] = getCombinedCost(child, leaf_node) + inherited_cost;
+            if(child.child1 != aabb_tree_null_node)
+                child_costs[i] -= getCost(child.min_x, child.min_y, child.max_x, child.max_y);
+        }
+
+        if(pair_cost < child_costs[0] && pair_cost < child_costs[1])
+            break;
+        index = child_costs[0] < child_costs[1] ? children[0] : children[1];
+    }
+    int sibling = index;
+
+    int old_parent = nodes[sibling].parent;
+    int new_parent = allocateNode();
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].child1 = sibling;
+    nodes[new_parent].child2 = leaf;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+    if(old_parent == aabb_tree_null_node)
+        root = new_parent;
+    else if(nodes[old_parent].child1 == sibling)
+        nodes[old_parent].child1 = new_parent;
+    else
+        nodes[old_parent].child2 = new_parent;
+
+    for(index = new_parent;index != aabb_tree_null_node;index = nodes[index].parent)
+    {
+        index = balance(index);
+        refit(index);
+    }
+}
+
+void AabbTree::removeLeaf(int leaf)
+{
+    if(leaf == root)
+    {
+        root = aabb_tree_null_node;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grand_parent = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    freeNode(parent);
+    nodes[sibling].parent = grand_parent;
+    nodes[leaf].parent = aabb_tree_null_node;
+    if(grand_parent == aabb_tree_null_node)
+    {
+        root = sibling;
+        return;
+    }
+
+    if(nodes[grand_parent].child1 == parent)
+        nodes[grand_parent].child1 = sibling;
+    else
+        nodes[grand_parent].child2 = sibling;
+
+    for(int index = grand_parent;index != aabb_tree_null_node;index = nodes[index].parent)
+    {
+        index = balance(index);
+        refit(index);
+    }
+}
+
+int AabbTree::balance(int index)
+{
+    AabbTreeNode& node = nodes[index];
+    if(node.child1 == aabb_tree_null_node || node.height < 2)
+        return index;
+
+    int child1 = node.child1;
+    int child2 = node.child2;
+    int difference = nodes[child2].height - nodes[child1].height;
+    if(difference >= -1 && difference <= 1)
+        return index;
+
+    //The deeper child takes the place of the node, the node keeps the shorter grandchild
+    int raised = difference > 1 ? child2 : child1;
+    int grandchild1 = nodes[raised].child1;
+    int grandchild2 = nodes[raised].child2;
+    int kept = nodes[grandchild1].height > nodes[grandchild2].height ? grandchild1 : grandchild2;
+    int moved = kept == grandchild1 ? grandchild2 : grandchild1;
+
+    int parent = node.parent;
+    nodes[raised].parent = parent;
+    if(parent == aabb_tree_null_node)
+        root = raised;
+    else if(nodes[parent].child1 == index)
+        nodes[parent].child1 = raised;
+    else
+        nodes[parent].child2 = raised;
+
+    nodes[raised].child1 = index;
+    nodes[raised].child2 = kept;
+    node.parent = raised;
+    if(raised == child2)
+        node.child2 = moved;
+    else
+        node.child1 = moved;
+    nodes[moved].parent = index;
+
+    refit(index);
+    refit(raised);
+    return raised;
+}
+
+void AabbTree::refit(int index)
+{
+    AabbTreeNode& node = nodes[index];
+    const AabbTreeNode& child1 = nodes[node.child1];
+    const AabbTreeNode& child2 = nodes[node.child2];
+    node.min_x = min(child1.min_x, child2.min_x);
+    node.min_y = min(child1.min_y, child2.min_y);
+    node.max_x = max(child1.max_x, child2.max_x);
+    node.max_y = max(child1.max_y, child2.max_y);
+    node.height = 1 + max(child1.height, child2.height);
+}
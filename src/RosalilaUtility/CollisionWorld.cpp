@@ -0,0 +1,204 @@
+#include "RosalilaUtility/RosalilaUtility.h"
+
+static int getCell(float position, float cell_size)
+{
+    return (int)floorf(position / cell_size);
+}
+
+static int getBucket(int x, int y, int bucket_count)
+{
+    return (int)(((unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u) & (unsigned int)(bucket_count - 1));
+}
+
+CollisionWorld::CollisionWorld()
+{
+    cell_size = collision_world_default_cell_size;
+    candidate_pairs = 0;
+}
+
+CollisionWorld::CollisionWorld(float cell_size)
+{
+    this->cell_size = cell_size > 0 ? cell_size : collision_world_default_cell_size;
+    candidate_pairs = 0;
+}
+
+int CollisionWorld::add(Hitbox* hitbox, unsigned int layer, unsigned int mask, void* data)
+{
+    CollisionWorldEntry entry;
+    entry.hitbox = hitbox;
+    entry.layer = layer;
+    entry.mask = mask;
+    entry.data = data;
+    entry.active = true;
+    entry.oversized = false;
+
+    if(!free_ids.empty())
+    {
+        int id = free_ids.back();
+        free_ids.pop_back();
+        entries[id] = entry;
+        return id;
+    }
+    entries.push_back(entry);
+    return (int)entries.size() - 1;
+}
+
+void CollisionWorld::remove(int id)
+{
+    if(id < 0 || id >= (int)entries.size() || !entries[id].active)
+        return;
+    entries[id].active = false;
+    entries[id].hitbox = NULL;
+    free_ids.push_back(id);
+}
+
+void CollisionWorld::clear()
+{
+    entries.clear();
+    free_ids.clear();
+    pairs.clear();
+}
+
+void CollisionWorld::setLayer(int id, unsigned int layer, unsigned int mask)
+{
+    entries[id].layer = layer;
+    entries[id].mask = mask;
+}
+
+Hitbox* CollisionWorld::getHitbox(int id)
+{
+    return entries[id].hitbox;
+}
+
+void* CollisionWorld::getData(int id)
+{
+    return entries[id].data;
+}
+
+const vector<CollisionPair>& CollisionWorld::queryPairs()
+{
+    ROSALILA_TRACE("CollisionWorld::queryPairs");
+    pairs.clear();
+    cells.clear();
+    oversized.clear();
+    candidate_pairs = 0;
+    boxes.resize(entries.size());
+
+    for(int id=0;id<(int)entries.size();id++)
+    {
+        CollisionWorldEntry& entry = entries[id];
+        entry.oversized = false;
+        if(!entry.active || (entry.layer == 0 && entry.mask == 0))
+            continue;
+
+        boxes[id] = entry.hitbox->getBox();
+        OrientedBox& box = boxes[id];
+        int min_x = getCell(box.min_x, cell_size);
+        int min_y = getCell(box.min_y, cell_size);
+        int max_x = getCell(box.max_x, cell_size);
+        int max_y = getCell(box.max_y, cell_size);
+        if((long long)(max_x - min_x + 1) * (max_y - min_y + 1) > collision_world_max_cells_per_box)
+        {
+            entry.oversized = true;
+            oversized.push_back(id);
+            continue;
+        }
+
+        for(int y=min_y;y<=max_y;y++)
+        {
+            for(int x=min_x;x<=max_x;x++)
+            {
+                CollisionWorldCell cell;
+                cell.x = x;
+                cell.y = y;
+                cell.id = id;
+                cells.push_back(cell);
+            }
+        }
+    }
+
+    //Counting sort by bucket, same cells end up next to each other
+    int bucket_count = 16;
+    while(bucket_count < (int)cells.size())
+        bucket_count *= 2;
+    bucket_starts.assign(bucket_count + 1, 0);
+    for(int i=0;i<(int)cells.size();i++)
+    {
+        cells[i].bucket = getBucket(cells[i].x, cells[i].y, bucket_count);
+        bucket_starts[cells[i].bucket]++;
+    }
+    int total = 0;
+    for(int i=0;i<bucket_count;i++)
+    {
+        total += bucket_starts[i];
+        bucket_starts[i] = total;
+    }
+    bucket_starts[bucket_count] = total;
+    sorted_cells.resize(cells.size());
+    for(int i=(int)cells.size()-1;i>=0;i--)
+        sorted_cells[--bucket_starts[cells[i].bucket]] = cells[i];
+
+    for(int bucket=0;bucket<bucket_count;bucket++)
+    {
+        int end = bucket_starts[bucket + 1];
+        for(int i=bucket_starts[bucket];i<end;i++)
+        {
+            const CollisionWorldCell& cell1 = sorted_cells[i];
+            for(int j=i+1;j<end;j++)
+            {
+                const CollisionWorldCell& cell2 = sorted_cells[j];
+                if(cell1.x != cell2.x || cell1.y != cell2.y)
+                    continue;
+                const CollisionWorldEntry& entry1 = entries[cell1.id];
+                const CollisionWorldEntry& entry2 = entries[cell2.id];
+                if(!(entry1.mask & entry2.layer) && !(entry2.mask & entry1.layer))
+                    continue;
+
+                //Hitboxes on more than one cell meet on several of them, only the cell with
+                //the top left corner of the overlap tests them
+                const OrientedBox& box1 = boxes[cell1.id];
+                const OrientedBox& box2 = boxes[cell2.id];
+                if(getCell(max(box1.min_x, box2.min_x), cell_size) != cell1.x
+                   || getCell(max(box1.min_y, box2.min_y), cell_size) != cell1.y)
+                    continue;
+
+                testPair(cell1.id, cell2.id);
+            }
+        }
+    }
+
+    for(int i=0;i<(int)oversized.size();i++)
+    {
+        int id1 = oversized[i];
+        for(int id2=0;id2<(int)entries.size();id2++)
+        {
+            if(id2 == id1 || !entries[id2].active)
+                continue;
+            //Oversized pairs once
+            if(entries[id2].oversized && id2 < id1)
+                continue;
+            testPair(id1, id2);
+        }
+    }
+
+    return pairs;
+}
+
+void CollisionWorld::testPair(int id1, int id2)
+{
+    CollisionWorldEntry& entry1 = entries[id1];
+    CollisionWorldEntry& entry2 = entries[id2];
+    bool hits1 = (entry1.mask & entry2.layer) != 0;
+    bool hits2 = (entry2.mask & entry1.layer) != 0;
+    if(!hits1 && !hits2)
+        return;
+
+    candidate_pairs++;
+    if(!boxes[id1].overlaps(boxes[id2]))
+        return;
+
+    CollisionPair pair;
+    pair.a = hits1 ? id1 : id2;
+    pair.b = hits1 ? id2 : id1;
+    pairs.push_back(pair);
+}
@@ -7,6 +7,8 @@ Hitbox::Hitbox(int x,int y,int width,int height,float angle)
     this->width=width;
     this->height=height;
     this->angle=angle;
+    this->cached_angle=angle;
+    OrientedBox::getSineCosine(angle,&sine,&cosine);
     setLines();
 }
 
@@ -17,6 +19,8 @@ Hitbox::Hitbox()
     this->width=0;
     this->height=0;
     this->angle=0;
+    this->cached_angle=0;
+    OrientedBox::getSineCosine(0,&sine,&cosine);
     setLines();
 }
 
@@ -81,20 +85,29 @@ void Hitbox::setValues(int x,int y, int width, int height,float angle)
     setLines();
 }
 
-bool Hitbox::collides(Hitbox hitbox_param)
+bool Hitbox::collides(const Hitbox& hitbox_param)
 {
-    return rosalila()->utility->hitboxLinesCollision(this->line1,this->line2,this->line3,this->line4,
-                                hitbox_param.line1,hitbox_param.line2,hitbox_param.line3,hitbox_param.line4);
+    return getBox().overlaps(hitbox_param.getBox());
 }
 
-bool Hitbox::collides(Hitbox hitbox_param,int hitbox_x,int hitbox_y,int hitbox_angle)
+bool Hitbox::collides(const Hitbox& hitbox_param,int hitbox_x,int hitbox_y,int hitbox_angle)
 {
-    hitbox_param.setX(hitbox_param.getX()+hitbox_x);
-    hitbox_param.setY(hitbox_param.getY()+hitbox_y);
-    hitbox_param.setAngle(hitbox_param.getAngle()+hitbox_angle);
-
-    return rosalila()->utility->hitboxLinesCollision(this->line1,this->line2,this->line3,this->line4,
-                                hitbox_param.line1,hitbox_param.line2,hitbox_param.line3,hitbox_param.line4);
+    //Same as moving a copy with the setters, without the copy
+    float placed_angle = hitbox_param.angle+hitbox_angle;
+    double placed_sine, placed_cosine;
+    if(placed_angle == hitbox_param.cached_angle)
+    {
+        placed_sine = hitbox_param.sine;
+        placed_cosine = hitbox_param.cosine;
+    }
+    else
+    {
+        OrientedBox::getSineCosine(placed_angle,&placed_sine,&placed_cosine);
+    }
+    OrientedBox placed;
+    placed.set(hitbox_param.x+hitbox_x,hitbox_param.y+hitbox_y,hitbox_param.width,hitbox_param.height,
+               (float)placed_sine,(float)placed_cosine);
+    return getBox().overlaps(placed);
 }
 
 Hitbox Hitbox::getPlacedHitbox(double x, double y)
@@ -103,9 +116,10 @@ Hitbox Hitbox::getPlacedHitbox(double x, double y)
     Point rotated=rosalila()->utility->rotateAroundPoint(Point(hitbox.getX(),hitbox.getY()),
                                     Point((int)x, (int)y),
                                     0);
-    hitbox.setX(rotated.x);
-    hitbox.setY(rotated.y);
-    hitbox.setAngle(0);
+    //Lines once for the three changes
+    hitbox.x=rotated.x;
+    hitbox.y=rotated.y;
+    hitbox.angle=0;
     hitbox.setLines();
     return hitbox;
 }
@@ -116,37 +130,56 @@ Hitbox Hitbox::getPlacedHitbox(double x, double y,float a)
     Point rotated=rosalila()->utility->rotateAroundPoint(Point(hitbox.getX(),hitbox.getY()),
                                     Point((int)x, (int)y),
                                     a+hitbox.getAngle());
-    hitbox.setX(rotated.x);
-    hitbox.setY(rotated.y);
-    hitbox.setAngle(a+hitbox.getAngle());
+    hitbox.x=rotated.x;
+    hitbox.y=rotated.y;
+    hitbox.angle=a+hitbox.getAngle();
     hitbox.setLines();
     return hitbox;
 }
 
 void Hitbox::setLines()
 {
+    if(angle != cached_angle)
+    {
+        OrientedBox::getSineCosine(angle,&sine,&cosine);
+        cached_angle = angle;
+    }
+
     Point point1(x,
               y);
 
-    Point point2((int)(x + cos (angle*PI/180) * width),
-				(int)(y - sin (angle*PI/180) * width));
+    Point point2((int)(x + cosine * width),
+				(int)(y - sine * width));
 
-    Point point3((int)(x + cos (angle*PI/180) * width + sin (angle*PI/180) * height),
-				(int)(y - sin (angle*PI/180) * width + cos (angle*PI/180) * height));
+    Point point3((int)(x + cosine * width + sine * height),
+				(int)(y - sine * width + cosine * height));
 
-    Point point4((int)(x + sin (angle*PI/180) * height),
-				(int)(y + cos (angle*PI/180) * height));
+    Point point4((int)(x + sine * height),
+				(int)(y + cosine * height));
 
 
     line1.set(point1,point2);
     line2.set(point2,point3);
     line3.set(point3,point4);
     line4.set(point4,point1);
+
+    box_outdated = true;
+}
+
+const OrientedBox& Hitbox::getBox() const
+{
+    if(box_outdated)
+    {
+        box.set(x,y,width,height,(float)sine,(float)cosine);
+        box_outdated = false;
+    }
+    return box;
 }
 
 Hitbox Hitbox::getFlippedHitbox()
 {
     Hitbox hitbox = *this;
     hitbox.x = -hitbox.x - hitbox.width;
+    hitbox.setLines();
     return hitbox;
 }
@@ -0,0 +1,296 @@
+#include "RosalilaUtility/RosalilaUtility.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define HITBOX_BATCH_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HITBOX_BATCH_SSE
+#endif
+
+//Every step is written the same way as OrientedBox::overlaps so the floats round the same
+static bool collidesScalar(const OrientedBox& a, HitboxBatch& b, int j)
+{
+    if(a.max_x < b.min_x[j] || b.max_x[j] < a.min_x
+       || a.max_y < b.min_y[j] || b.max_y[j] < a.min_y)
+        return false;
+
+    float distance_x = b.center_x[j] - a.center_x;
+    float distance_y = b.center_y[j] - a.center_y;
+    float alignment00 = fabsf(a.axis_x[0] * b.axis0_x[j] + a.axis_y[0] * b.axis0_y[j]);
+    float alignment01 = fabsf(a.axis_x[0] * b.axis1_x[j] + a.axis_y[0] * b.axis1_y[j]);
+    float alignment10 = fabsf(a.axis_x[1] * b.axis0_x[j] + a.axis_y[1] * b.axis0_y[j]);
+    float alignment11 = fabsf(a.axis_x[1] * b.axis1_x[j] + a.axis_y[1] * b.axis1_y[j]);
+
+    if(fabsf(distance_x * a.axis_x[0] + distance_y * a.axis_y[0])
+       > a.half_extent[0] + alignment00 * b.half_width[j] + alignment01 * b.half_height[j])
+        return false;
+    if(fabsf(distance_x * a.axis_x[1] + distance_y * a.axis_y[1])
+       > a.half_extent[1] + alignment10 * b.half_width[j] + alignment11 * b.half_height[j])
+        return false;
+    if(fabsf(distance_x * b.axis0_x[j] + distance_y * b.axis0_y[j])
+       > b.half_width[j] + alignment00 * a.half_extent[0] + alignment10 * a.half_extent[1])
+        return false;
+    if(fabsf(distance_x * b.axis1_x[j] + distance_y * b.axis1_y[j])
+       > b.half_height[j] + alignment01 * a.half_extent[0] + alignment11 * a.half_extent[1])
+        return false;
+    return true;
+}
+
+#ifdef HITBOX_BATCH_SSE
+//Boxes j to j+3, one bit each
+static int collidesSse(const OrientedBox& a, HitboxBatch& b, int j)
+{
+    const __m128 absolute = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    //Not less than instead of greater or equal, same as the scalar test
+    __m128 hit = _mm_and_ps(_mm_cmpnlt_ps(_mm_set1_ps(a.max_x), _mm_loadu_ps(&b.min_x[j])),
+                            _mm_cmpnlt_ps(_mm_loadu_ps(&b.max_x[j]), _mm_set1_ps(a.min_x)));
+    hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpnlt_ps(_mm_set1_ps(a.max_y), _mm_loadu_ps(&b.min_y[j])),
+                                     _mm_cmpnlt_ps(_mm_loadu_ps(&b.max_y[j]), _mm_set1_ps(a.min_y))));
+    if(_mm_movemask_ps(hit) == 0)
+        return 0;
+
+    __m128 a_axis0_x = _mm_set1_ps(a.axis_x[0]);
+    __m128 a_axis0_y = _mm_set1_ps(a.axis_y[0]);
+    __m128 a_axis1_x = _mm_set1_ps(a.axis_x[1]);
+    __m128 a_axis1_y = _mm_set1_ps(a.axis_y[1]);
+    __m128 a_half_width = _mm_set1_ps(a.half_extent[0]);
+    __m128 a_half_height = _mm_set1_ps(a.half_extent[1]);
+    __m128 b_axis0_x = _mm_loadu_ps(&b.axis0_x[j]);
+    __m128 b_axis0_y = _mm_loadu_ps(&b.axis0_y[j]);
+    __m128 b_axis1_x = _mm_loadu_ps(&b.axis1_x[j]);
+    __m128 b_axis1_y = _mm_loadu_ps(&b.axis1_y[j]);
+    __m128 b_half_width = _mm_loadu_ps(&b.half_width[j]);
+    __m128 b_half_height = _mm_loadu_ps(&b.half_height[j]);
+
+    __m128 distance_x = _mm_sub_ps(_mm_loadu_ps(&b.center_x[j]), _mm_set1_ps(a.center_x));
+    __m128 distance_y = _mm_sub_ps(_mm_loadu_ps(&b.center_y[j]), _mm_set1_ps(a.center_y));
+    __m128 alignment00 = _mm_and_ps(absolute, _mm_add_ps(_mm_mul_ps(a_axis0_x, b_axis0_x), _mm_mul_ps(a_axis0_y, b_axis0_y)));
+    __m128 alignment01 = _mm_and_ps(absolute, _mm_add_ps(_mm_mul_ps(a_axis0_x, b_axis1_x), _mm_mul_ps(a_axis0_y, b_axis1_y)));
+    __m128 alignment10 = _mm_and_ps(absolute, _mm_add_ps(_mm_mul_ps(a_axis1_x, b_axis0_x), _mm_mul_ps(a_axis1_y, b_axis0_y)));
+    __m128 alignment11 = _mm_and_ps(absolute, _mm_add_ps(_mm_mul_ps(a_axis1_x, b_axis1_x), _mm_mul_ps(a_axis1_y, b_axis1_y)));
+
+    __m128 distance = _mm_and_ps(absolute, _mm_add_ps(_mm_mul_ps(distance_x, a_axis0_x), _mm_mul_ps(distance_y, a_axis0_y)));
+    __m128 reach = _mm_add_ps(_mm_add_ps(a_half_width, _mm_mul_ps(alignment00, b_half_width)), _mm_mul_ps(alignment01, b_half_height));
+    hit = _mm_and_ps(hit, _mm_cmpngt_ps(distance, reach));
+
+    distance = _mm_and_ps(absolute, _mm_add_ps(_mm_mul_ps(distance_x, a_axis1_x), _mm_mul_ps(distance_y, a_axis1_y)));
+    reach = _mm_add_ps(_mm_add_ps(a_half_height, _mm_mul_ps(alignment10, b_half_width)), _mm_mul_ps(alignment11, b_half_height));
+    hit = _mm_and_ps(hit, _mm_cmpngt_ps(distance, reach));
+
+    distance = _mm_and_ps(absolute, _mm_add_ps(_mm_mul_ps(distance_x, b_axis0_x), _mm_mul_ps(distance_y, b_axis0_y)));
+    reach = _mm_add_ps(_mm_add_ps(b_half_width, _mm_mul_ps(alignment00, a_half_width)), _mm_mul_ps(alignment10, a_half_height));
+    hit = _mm_and_ps(hit, _mm_cmpngt_ps(distance, reach));
+
+    distance = _mm_and_ps(absolute, _mm_add_ps(_mm_mul_ps(distance_x, b_axis1_x), _mm_mul_ps(distance_y, b_axis1_y)));
+    reach = _mm_add_ps(_mm_add_ps(b_half_height, _mm_mul_ps(alignment01, a_half_width)), _mm_mul_ps(alignment11, a_half_height));
+    hit = _mm_and_ps(hit, _mm_cmpngt_ps(distance, reach));
+
+    return _mm_movemask_ps(hit);
+}
+#endif
+
+#ifdef HITBOX_BATCH_AVX
+//Boxes j to j+7, one bit each
+static int collidesAvx(const OrientedBox& a, HitboxBatch& b, int j)
+{
+    const __m256 absolute = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+    //Not less than instead of greater or equal, same as the scalar test
+    __m256 hit = _mm256_and_ps(_mm256_cmp_ps(_mm256_set1_ps(a.max_x), _mm256_loadu_ps(&b.min_x[j]), _CMP_NLT_UQ),
+                               _mm256_cmp_ps(_mm256_loadu_ps(&b.max_x[j]), _mm256_set1_ps(a.min_x), _CMP_NLT_UQ));
+    hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(_mm256_set1_ps(a.max_y), _mm256_loadu_ps(&b.min_y[j]), _CMP_NLT_UQ),
+                                           _mm256_cmp_ps(_mm256_loadu_ps(&b.max_y[j]), _mm256_set1_ps(a.min_y), _CMP_NLT_UQ)));
+    if(_mm256_movemask_ps(hit) == 0)
+        return 0;
+
+    __m256 a_axis0_x = _mm256_set1_ps(a.axis_x[0]);
+    __m256 a_axis0_y = _mm256_set1_ps(a.axis_y[0]);
+    __m256 a_axis1_x = _mm256_set1_ps(a.axis_x[1]);
+    __m256 a_axis1_y = _mm256_set1_ps(a.axis_y[1]);
+    __m256 a_half_width = _mm256_set1_ps(a.half_extent[0]);
+    __m256 a_half_height = _mm256_set1_ps(a.half_extent[1]);
+    __m256 b_axis0_x = _mm256_loadu_ps(&b.axis0_x[j]);
+    __m256 b_axis0_y = _mm256_loadu_ps(&b.axis0_y[j]);
+    __m256 b_axis1_x = _mm256_loadu_ps(&b.axis1_x[j]);
+    __m256 b_axis1_y = _mm256_loadu_ps(&b.axis1_y[j]);
+    __m256 b_half_width = _mm256_loadu_ps(&b.half_width[j]);
+    __m256 b_half_height = _mm256_loadu_ps(&b.half_height[j]);
+
+    __m256 distance_x = _mm256_sub_ps(_mm256_loadu_ps(&b.center_x[j]), _mm256_set1_ps(a.center_x));
+    __m256 distance_y = _mm256_sub_ps(_mm256_loadu_ps(&b.center_y[j]), _mm256_set1_ps(a.center_y));
+    __m256 alignment00 = _mm256_and_ps(absolute, _mm256_add_ps(_mm256_mul_ps(a_axis0_x, b_axis0_x), _mm256_mul_ps(a_axis0_y, b_axis0_y)));
+    __m256 alignment01 = _mm256_and_ps(absolute, _mm256_add_ps(_mm256_mul_ps(a_axis0_x, b_axis1_x), _mm256_mul_ps(a_axis0_y, b_axis1_y)));
+    __m256 alignment10 = _mm256_and_ps(absolute, _mm256_add_ps(_mm256_mul_ps(a_axis1_x, b_axis0_x), _mm256_mul_ps(a_axis1_y, b_axis0_y)));
+    __m256 alignment11 = _mm256_and_ps(absolute, _mm256_add_ps(_mm256_mul_ps(a_axis1_x, b_axis1_x), _mm256_mul_ps(a_axis1_y, b_axis1_y)));
+
+    __m256 distance = _mm256_and_ps(absolute, _mm256_add_ps(_mm256_mul_ps(distance_x, a_axis0_x), _mm256_mul_ps(distance_y, a_axis0_y)));
+    __m256 reach = _mm256_add_ps(_mm256_add_ps(a_half_width, _mm256_mul_ps(alignment00, b_half_width)), _mm256_mul_ps(alignment01, b_half_height));
+    hit = _mm256_and_ps(hit, _mm256_cmp_ps(distance, reach, _CMP_NGT_UQ));
+
+    distance = _mm256_and_ps(absolute, _mm256_add_ps(_mm256_mul_ps(distance_x, a_axis1_x), _mm256_mul_ps(distance_y, a_axis1_y)));
+    reach = _mm256_add_ps(_mm256_add_ps(a_half_height, _mm256_mul_ps(alignment10, b_half_width)), _mm256_mul_ps(alignment11, b_half_height));
+    hit = _mm256_and_ps(hit, _mm256_cmp_ps(distance, reach, _CMP_NGT_UQ));
+
+    distance = _mm256_and_ps(absolute, _mm256_add_ps(_mm256_mul_ps(distance_x, b_axis0_x), _mm256_mul_ps(distance_y, b_axis0_y)));
+    reach = _mm256_add_ps(_mm256_add_ps(b_half_width, _mm256_mul_ps(alignment00, a_half_width)), _mm256_mul_ps(alignment10, a_half_height));
+    hit = _mm256_and_ps(hit, _mm256_cmp_ps(distance, reach, _CMP_NGT_UQ));
+
+    distance = _mm256_and_ps(absolute, _mm256_add_ps(_mm256_mul_ps(distance_x, b_axis1_x), _mm256_mul_ps(distance_y, b_axis1_y)));
+    reach = _mm256_add_ps(_mm256_add_ps(b_half_height, _mm256_mul_ps(alignment01, a_half_width)), _mm256_mul_ps(alignment11, a_half_height));
+    hit = _mm256_and_ps(hit, _mm256_cmp_ps(distance, reach, _CMP_NGT_UQ));
+
+    return _mm256_movemask_ps(hit);
+}
+#endif
+
+HitboxBatch::HitboxBatch()
+{
+    simd = true;
+}
+
+void HitboxBatch::clear()
+{
+    center_x.clear();
+    center_y.clear();
+    axis0_x.clear();
+    axis0_y.clear();
+    axis1_x.clear();
+    axis1_y.clear();
+    half_width.clear();
+    half_height.clear();
+    min_x.clear();
+    min_y.clear();
+    max_x.clear();
+    max_y.clear();
+}
+
+void HitboxBatch::reserve(int size)
+{
+    center_x.reserve(size);
+    center_y.reserve(size);
+    axis0_x.reserve(size);
+    axis0_y.reserve(size);
+    axis1_x.reserve(size);
+    axis1_y.reserve(size);
+    half_width.reserve(size);
+    half_height.reserve(size);
+    min_x.reserve(size);
+    min_y.reserve(size);
+    max_x.reserve(size);
+    max_y.reserve(size);
+}
+
+int HitboxBatch::size()
+{
+    return (int)center_x.size();
+}
+
+int HitboxBatch::add(const OrientedBox& box)
+{
+    int index = size();
+    center_x.push_back(box.center_x);
+    center_y.push_back(box.center_y);
+    axis0_x.push_back(box.axis_x[0]);
+    axis0_y.push_back(box.axis_y[0]);
+    axis1_x.push_back(box.axis_x[1]);
+    axis1_y.push_back(box.axis_y[1]);
+    half_width.push_back(box.half_extent[0]);
+    half_height.push_back(box.half_extent[1]);
+    min_x.push_back(box.min_x);
+    min_y.push_back(box.min_y);
+    max_x.push_back(box.max_x);
+    max_y.push_back(box.max_y);
+    return index;
+}
+
+int HitboxBatch::add(Hitbox* hitbox)
+{
+    return add(hitbox->getBox());
+}
+
+void HitboxBatch::set(int index, const OrientedBox& box)
+{
+    center_x[index] = box.center_x;
+    center_y[index] = box.center_y;
+    axis0_x[index] = box.axis_x[0];
+    axis0_y[index] = box.axis_y[0];
+    axis1_x[index] = box.axis_x[1];
+    axis1_y[index] = box.axis_y[1];
+    half_width[index] = box.half_extent[0];
+    half_height[index] = box.half_extent[1];
+    min_x[index] = box.min_x;
+    min_y[index] = box.min_y;
+    max_x[index] = box.max_x;
+    max_y[index] = box.max_y;
+}
+
+void HitboxBatch::collides(const OrientedBox& box, int first, int count, unsigned int* hits)
+{
+    for(int i=0;i<(count + 31) / 32;i++)
+        hits[i] = 0;
+
+    //Groups start on multiples of 8 or 4, they never go over a word
+    int i = 0;
+#ifdef HITBOX_BATCH_AVX
+    if(simd)
+        for(;i+8<=count;i+=8)
+            hits[i / 32] |= (unsigned int)collidesAvx(box, *this, first + i) << (i % 32);
+#endif
+#ifdef HITBOX_BATCH_SSE
+    if(simd)
+        for(;i+4<=count;i+=4)
+            hits[i / 32] |= (unsigned int)collidesSse(box, *this, first + i) << (i % 32);
+#endif
+    for(;i<count;i++)
+        if(collidesScalar(box, *this, first + i))
+            hits[i / 32] |= 1u << (i % 32);
+}
+
+void HitboxBatch::collides(const OrientedBox& box, vector<unsigned int>& hits)
+{
+    ROSALILA_TRACE("HitboxBatch::collides");
+    hits.resize((size() + 31) / 32);
+    if(!hits.empty())
+        collides(box, 0, size(), &hits[0]);
+}
+
+void HitboxBatch::collides(HitboxBatch& others, vector<unsigned int>& hits)
+{
+    ROSALILA_TRACE("HitboxBatch::collides");
+    int words = (others.size() + 31) / 32;
+    hits.resize(size() * words);
+    if(words == 0)
+        return;
+
+    //Only the members the test reads
+    OrientedBox box;
+    for(int i=0;i<size();i++)
+    {
+        box.center_x = center_x[i];
+        box.center_y = center_y[i];
+        box.axis_x[0] = axis0_x[i];
+        box.axis_y[0] = axis0_y[i];
+        box.axis_x[1] = axis1_x[i];
+        box.axis_y[1] = axis1_y[i];
+        box.half_extent[0] = half_width[i];
+        box.half_extent[1] = half_height[i];
+        box.min_x = min_x[i];
+        box.min_y = min_y[i];
+        box.max_x = max_x[i];
+        box.max_y = max_y[i];
+        others.collides(box, 0, others.size(), &hits[i * words]);
+    }
+}
+
+string HitboxBatch::getInstructionSet()
+{
+#if defined(HITBOX_BATCH_AVX)
+    return simd ? "AVX" : "None";
+#elif defined(HITBOX_BATCH_SSE)
+    return simd ? "SSE" : "None";
+#else
+    return "None";
+#endif
+}
@@ -0,0 +1,232 @@
+#include "RosalilaUtility/RosalilaUtility.h"
+
+static Uint32 hashText(const string& text)
+{
+    //FNV-1a
+    Uint32 hash = 2166136261u;
+    for(int i=0;i<(int)text.size();i++)
+    {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static const char* getLevelPrefix(LogLevel level)
+{
+    switch(level)
+    {
+        case LOG_DEBUG: return "Debug: ";
+        case LOG_WARNING: return "Warning: ";
+        case LOG_ERROR: return "Error: ";
+        default: return "";
+    }
+}
+
+static void stopLogger()
+{
+    rosalila()->utility->logger.stop();
+}
+
+Logger::Logger()
+{
+    min_level = LOG_INFO;
+    queue = new LogMessage[logger_queue_size];
+    for(int i=0;i<logger_queue_size;i++)
+        queue[i].sequence.store(i);
+    write_position.store(0);
+    read_position = 0;
+    for(int i=0;i<logger_rate_slots;i++)
+    {
+        rate_slots[i].hash.store(0);
+        rate_slots[i].second.store(0);
+        rate_slots[i].count.store(0);
+        rate_slots[i].skipped.store(0);
+    }
+    dropped.store(0);
+    clear_requested.store(false);
+    start_counter = SDL_GetPerformanceCounter();
+    frequency = SDL_GetPerformanceFrequency();
+    thread = NULL;
+    semaphore = NULL;
+    mutex = NULL;
+    running.store(false);
+    started = false;
+}
+
+void Logger::start(string filename)
+{
+    if(started)
+    {
+        clear();
+        return;
+    }
+    this->filename = filename;
+    file.open(filename.c_str(), ios::out | ios::trunc);
+    semaphore = SDL_CreateSemaphore(0);
+    mutex = SDL_CreateMutex();
+    running.store(true);
+    thread = SDL_CreateThread(threadFunction, "RosalilaLogger", this);
+    started = true;
+    atexit(stopLogger);
+    if(!thread)
+        write(LOG_WARNING, "Could not start the logger thread, lines are written right away.");
+}
+
+void Logger::stop()
+{
+    if(!started)
+        return;
+    running.store(false);
+    if(thread)
+    {
+        SDL_SemPost(semaphore);
+        SDL_WaitThread(thread, NULL);
+        thread = NULL;
+    }
+    flush();
+    file.close();
+    SDL_DestroySemaphore(semaphore);
+    SDL_DestroyMutex(mutex);
+    semaphore = NULL;
+    mutex = NULL;
+    started = false;
+}
+
+void Logger::clear()
+{
+    clear_requested.store(true);
+    if(semaphore)
+        SDL_SemPost(semaphore);
+}
+
+bool Logger::write(LogLevel level, string text)
+{
+    if(level < min_level)
+        return true;
+
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    //Repeated lines, the counters are shared by every line with the same slot so it is approximate
+    Uint32 hash = hashText(text);
+    Uint32 second = (Uint32)((now - start_counter) / frequency);
+    LogRateSlot& slot = rate_slots[hash % logger_rate_slots];
+    int skipped = 0;
+    if(slot.hash.load(std::memory_order_relaxed) == hash && slot.second.load(std::memory_order_relaxed) == second)
+    {
+        if(slot.count.fetch_add(1, std::memory_order_relaxed) >= logger_max_repeats_per_second)
+        {
+            slot.skipped.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    else
+    {
+        if(slot.hash.load(std::memory_order_relaxed) == hash)
+            skipped = slot.skipped.exchange(0, std::memory_order_relaxed);
+        else
+            slot.skipped.store(0, std::memory_order_relaxed);
+        slot.hash.store(hash, std::memory_order_relaxed);
+        slot.second.store(second, std::memory_order_relaxed);
+        slot.count.store(1, std::memory_order_relaxed);
+    }
+
+    //Bounded queue: a slot is free to write when its sequence is the position and ready to read when it is one more
+    Uint32 position = write_position.load(std::memory_order_relaxed);
+    LogMessage* message;
+    while(true)
+    {
+        message = &queue[position & (logger_queue_size - 1)];
+        Uint32 sequence = message->sequence.load(std::memory_order_acquire);
+        int difference = (int)(sequence - position);
+        if(difference == 0)
+        {
+            if(write_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if(difference < 0)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            position = write_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    message->level = level;
+    message->time = now;
+    message->skipped = skipped;
+    message->length = text.size() < (size_t)logger_max_line_length ? (int)text.size() : logger_max_line_length;
+    memcpy(message->text, text.c_str(), message->length);
+    message->sequence.store(position + 1, std::memory_order_release);
+
+    if(thread)
+    {
+        SDL_SemPost(semaphore);
+    }
+    else if(started)
+    {
+        SDL_LockMutex(mutex);
+        flush();
+        SDL_UnlockMutex(mutex);
+    }
+    return true;
+}
+
+void Logger::flush()
+{
+    if(clear_requested.exchange(false))
+    {
+        file.close();
+        file.open(filename.c_str(), ios::out | ios::trunc);
+    }
+
+    bool written = false;
+    int lost = dropped.exchange(0, std::memory_order_relaxed);
+    if(lost > 0)
+    {
+        file<<"Warning: "<<lost<<" log lines were dropped, the queue was full.\n";
+        written = true;
+    }
+
+    while(true)
+    {
+        LogMessage& message = queue[read_position & (logger_queue_size - 1)];
+        Uint32 sequence = message.sequence.load(std::memory_order_acquire);
+        if((int)(sequence - (read_position + 1)) < 0)
+            break;
+
+        char time[32];
+        snprintf(time, sizeof(time), "[%.3f] ", (double)(message.time - start_counter) / frequency);
+        file<<time<<getLevelPrefix(message.level);
+        file.write(message.text, message.length);
+        if(message.skipped > 0)
+            file<<" ("<<message.skipped<<" repeats skipped)";
+        file<<"\n";
+        written = true;
+
+        message.sequence.store(read_position + logger_queue_size, std::memory_order_release);
+        read_position++;
+    }
+
+    if(written)
+        file.flush();
+}
+
+int Logger::threadFunction(void* data)
+{
+    ((Logger*)data)->work();
+    return 0;
+}
+
+void Logger::work()
+{
+    rosalila()->utility->tracer.setThreadName("RosalilaLogger");
+    while(running.load())
+    {
+        SDL_SemWaitTimeout(semaphore, 100);
+        flush();
+    }
+}
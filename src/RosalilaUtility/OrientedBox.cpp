@@ -0,0 +1,141 @@
+#include "RosalilaUtility/RosalilaUtility.h"
+
+//Whole degrees from -360 to 719, turned angles added together stay on it. Not wrapped to 0-359
+//since the sine of the same angle one turn later is off on the last bits and that moves the int corners.
+const int degree_table_first = -360;
+const int degree_table_size = 1080;
+
+class DegreeTable
+{
+public:
+    double sines[degree_table_size];
+    double cosines[degree_table_size];
+
+    DegreeTable()
+    {
+        for(int i=0;i<degree_table_size;i++)
+        {
+            double degrees = i + degree_table_first;
+            sines[i] = sin(degrees*PI/180);
+            cosines[i] = cos(degrees*PI/180);
+        }
+    }
+};
+
+//Built on the first use, hitboxes can be made before main
+static const DegreeTable& getDegreeTable()
+{
+    static DegreeTable table;
+    return table;
+}
+
+OrientedBox::OrientedBox()
+{
+    set(0,0,0,0,0.0f,1.0f);
+}
+
+OrientedBox::OrientedBox(float x,float y,float width,float height,float angle)
+{
+    set(x,y,width,height,angle);
+}
+
+void OrientedBox::set(float x,float y,float width,float height,float angle)
+{
+    double sine, cosine;
+    getSineCosine(angle,&sine,&cosine);
+    set(x,y,width,height,(float)sine,(float)cosine);
+}
+
+void OrientedBox::set(float x,float y,float width,float height,float sine,float cosine)
+{
+    axis_x[0] = cosine;
+    axis_y[0] = -sine;
+    axis_x[1] = sine;
+    axis_y[1] = cosine;
+
+    float width_x = axis_x[0] * width;
+    float width_y = axis_y[0] * width;
+    float height_x = axis_x[1] * height;
+    float height_y = axis_y[1] * height;
+
+    corner_x[0] = x;
+    corner_y[0] = y;
+    corner_x[1] = x + width_x;
+    corner_y[1] = y + width_y;
+    corner_x[2] = x + width_x + height_x;
+    corner_y[2] = y + width_y + height_y;
+    corner_x[3] = x + height_x;
+    corner_y[3] = y + height_y;
+
+    //Flipped hitboxes can have a negative size
+    half_extent[0] = fabsf(width) * 0.5f;
+    half_extent[1] = fabsf(height) * 0.5f;
+    center_x = x + (width_x + height_x) * 0.5f;
+    center_y = y + (width_y + height_y) * 0.5f;
+
+    min_x = max_x = corner_x[0];
+    min_y = max_y = corner_y[0];
+    for(int i=1;i<4;i++)
+    {
+        if(corner_x[i] < min_x)
+            min_x = corner_x[i];
+        if(corner_x[i] > max_x)
+            max_x = corner_x[i];
+        if(corner_y[i] < min_y)
+            min_y = corner_y[i];
+        if(corner_y[i] > max_y)
+            max_y = corner_y[i];
+    }
+}
+
+bool OrientedBox::overlaps(const OrientedBox& box) const
+{
+    //Most pairs are far apart
+    if(max_x < box.min_x || box.max_x < min_x
+       || max_y < box.min_y || box.max_y < min_y)
+        return false;
+
+    float distance_x = box.center_x - center_x;
+    float distance_y = box.center_y - center_y;
+
+    //How much each axis of this box lines up with each axis of the other one
+    float alignment[2][2];
+    for(int i=0;i<2;i++)
+        for(int j=0;j<2;j++)
+            alignment[i][j] = fabsf(axis_x[i] * box.axis_x[j] + axis_y[i] * box.axis_y[j]);
+
+    //Both boxes are rectangles, their edges give the only four axes that can separate them
+    for(int i=0;i<2;i++)
+    {
+        float distance = fabsf(distance_x * axis_x[i] + distance_y * axis_y[i]);
+        float reach = half_extent[i]
+                      + alignment[i][0] * box.half_extent[0]
+                      + alignment[i][1] * box.half_extent[1];
+        if(distance > reach)
+            return false;
+    }
+    for(int j=0;j<2;j++)
+    {
+        float distance = fabsf(distance_x * box.axis_x[j] + distance_y * box.axis_y[j]);
+        float reach = box.half_extent[j]
+                      + alignment[0][j] * half_extent[0]
+                      + alignment[1][j] * half_extent[1];
+        if(distance > reach)
+            return false;
+    }
+    return true;
+}
+
+void OrientedBox::getSineCosine(float angle, double* sine, double* cosine)
+{
+    if(angle >= degree_table_first && angle < degree_table_first + degree_table_size && (int)angle == angle)
+    {
+        const DegreeTable& table = getDegreeTable();
+        int index = (int)angle - degree_table_first;
+        *sine = table.sines[index];
+        *cosine = table.cosines[index];
+        return;
+    }
+    *sine = sin(angle*PI/180);
+    *cosine = cos(angle*PI/180);
+}
@@ -0,0 +1,140 @@
+#include "RosalilaUtility/RosalilaUtility.h"
+
+bool Tracer::enabled = false;
+
+static thread_local TraceBuffer* thread_buffer = NULL;
+
+static string escapeJson(string text)
+{
+    string escaped;
+    for(int i=0;i<(int)text.size();i++)
+    {
+        if(text[i] == '"' || text[i] == '\\')
+            escaped += '\\';
+        escaped += text[i];
+    }
+    return escaped;
+}
+
+Tracer::Tracer()
+{
+    start_counter = 0;
+    mutex = NULL;
+}
+
+Tracer::~Tracer()
+{
+    enabled = false;
+    for(int i=0;i<(int)buffers.size();i++)
+        delete buffers[i];
+    if(mutex)
+        SDL_DestroyMutex(mutex);
+}
+
+void Tracer::start()
+{
+    if(!mutex)
+        mutex = SDL_CreateMutex();
+    if(start_counter == 0)
+        start_counter = SDL_GetPerformanceCounter();
+    enabled = true;
+}
+
+void Tracer::stop()
+{
+    enabled = false;
+}
+
+void Tracer::setThreadName(string name)
+{
+    if(!enabled)
+        return;
+    TraceBuffer* buffer = getThreadBuffer();
+    SDL_LockMutex(mutex);
+    buffer->thread_name = name;
+    SDL_UnlockMutex(mutex);
+}
+
+TraceBuffer* Tracer::getThreadBuffer()
+{
+    if(thread_buffer)
+        return thread_buffer;
+    thread_buffer = new TraceBuffer();
+    thread_buffer->thread = SDL_ThreadID();
+    thread_buffer->events.resize(trace_buffer_size);
+    thread_buffer->count.store(0);
+    SDL_LockMutex(mutex);
+    buffers.push_back(thread_buffer);
+    SDL_UnlockMutex(mutex);
+    return thread_buffer;
+}
+
+void Tracer::record(const char* name, Uint64 start, Uint64 end)
+{
+    TraceBuffer* buffer = getThreadBuffer();
+    Uint64 index = buffer->count.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[index % trace_buffer_size];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+bool Tracer::exportChromeTrace(string filename)
+{
+    if(!mutex)
+        return false;
+    ofstream file(filename.c_str());
+    if(!file.is_open())
+    {
+        rosalila()->utility->writeLogLine("Warning: Could not write the trace to " + filename + ".");
+        return false;
+    }
+
+    double microseconds = 1000000.0 / SDL_GetPerformanceFrequency();
+    bool first = true;
+    file<<"{\"traceEvents\":[";
+    SDL_LockMutex(mutex);
+    for(int i=0;i<(int)buffers.size();i++)
+    {
+        TraceBuffer* buffer = buffers[i];
+        if(buffer->thread_name != "")
+        {
+            file<<(first ? "\n" : ",\n");
+            first = false;
+            file<<"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"<<buffer->thread
+                <<",\"args\":{\"name\":\""<<escapeJson(buffer->thread_name)<<"\"}}";
+        }
+
+        Uint64 count = buffer->count.load(std::memory_order_acquire);
+        Uint64 first_event = count > (Uint64)trace_buffer_size ? count - trace_buffer_size : 0;
+        vector<TraceEvent> events;
+        for(Uint64 event=first_event;event<count;event++)
+            events.push_back(buffer->events[event % trace_buffer_size]);
+
+        //The thread may have written over the oldest ones while they were copied
+        std::atomic_thread_fence(std::memory_order_acquire);
+        Uint64 written = buffer->count.load(std::memory_order_relaxed);
+        Uint64 valid_from = written > (Uint64)trace_buffer_size ? written - trace_buffer_size : 0;
+        for(int j=0;j<(int)events.size();j++)
+        {
+            if(first_event + j < valid_from || events[j].start < start_counter)
+                continue;
+            char line[512];
+            snprintf(line, sizeof(line), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+                     escapeJson(events[j].name).c_str(), (unsigned long)buffer->thread,
+                     (events[j].start - start_counter) * microseconds,
+                     (events[j].end - events[j].start) * microseconds);
+            file<<(first ? "\n" : ",\n")<<line;
+            first = false;
+        }
+    }
+    SDL_UnlockMutex(mutex);
+    file<<"\n]}\n";
+    return file.good();
+}
+
+void TraceScope::end()
+{
+    rosalila()->utility->tracer.record(name, start, SDL_GetPerformanceCounter());
+}